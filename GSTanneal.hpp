@@ -0,0 +1,634 @@
+#pragma once
+
+#include "GSTrevise.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+#pragma region Annealing
+/* Simulated annealing over the topology of a GST. The leaves and their
+	 curves stay as they are; a move changes which subtrees are combined, and
+	 only the nodes whose children changed and their ancestors are combined
+	 again. The nodes a move recombines keep their old curves aside until the
+	 move is accepted or rolled back, so a rejected move costs no combine.
+
+	 Swapping the children of a node or the direction of a cut changes
+	 nothing in a GST: the combine does not depend on the order of the
+	 children, and the flip already puts both cuts into every curve. The
+	 moves that do change a curve are the ones on the tree itself:
+	 Swap exchanges two disjoint subtrees, leaves included, which is the swap
+	 of two operands in a Polish expression. Rotate moves a grandchild of a
+	 node up next to its parent's sibling, ((x, y), s) becoming (x, (y, s)),
+	 the operator moves of a Polish expression.
+
+	 Nodes stay in topological order, so a move whose subtrees would come
+	 after their new parent is not made. The cost of a tree is the least area
+	 of its root curve, of the root points that fit GST::outlineW x outlineH
+	 if an outline is set. The area limits and shape ranges of evaluateGST
+	 depend on the topology, so the chains combine without them.
+
+	 A chain does not own its curves. The curve of a subtree depends only on
+	 the leaves below it and how they are grouped, so curves are immutable
+	 and held through shared pointers, and a SubtreeCache hands the same
+	 curve to every chain that builds the same subtree. Chains run side by
+	 side by parallel tempering share the leaves and every subtree they have
+	 in common, and a move that is rolled back just drops its pointers */
+
+/* Curves of subtrees, shared by the chains that contain them. A subtree is
+	 identified like a node of a GSTBatch, by the unordered pair of the ids of
+	 its children, leaves having their index as id, so the same subtree gets
+	 the same id in every chain. Curves are held weakly and live as long as a
+	 chain uses them; the ids of subtrees no chain uses are dropped whenever
+	 the table has doubled. Ids are never reused, as chains may still hold
+	 the id of a dropped subtree, so they are 64 bits wide and do not wrap
+	 within any run */
+struct SubtreeCache
+{
+	using Key = std::pair<uint64_t, uint64_t>;
+
+	struct Entry
+	{
+		uint64_t id;
+		std::weak_ptr<Subcircuit const> curve;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(Key const& k) const { return std::hash<uint64_t>()(k.first * 0x9e3779b97f4a7c15ull ^ k.second); }
+	};
+
+	explicit SubtreeCache(int numPi) : nextId(numPi) {}
+
+	std::mutex mutex;
+	std::unordered_map<Key, Entry, KeyHash> entries;
+	uint64_t nextId;
+	size_t cleanAt = 1 << 16;
+};
+
+using CurveHandle = std::shared_ptr<Subcircuit const>;
+
+/* A tree being annealed. The chain keeps the topology and a handle and
+	 cache id per node; its GST holds the settings and the topology, and is
+	 used with three nodes of its own to combine. While a move is pending,
+	 the state it replaced is kept in the saved fields */
+struct AnnealChain
+{
+	GST gst;
+	std::vector<Node> leftChild, rightChild, parent;
+	std::vector<CurveHandle> curve;
+	std::vector<uint64_t> id;
+	SubtreeCache* cache = nullptr;
+	double cost = INFINITY;
+	/* Costs are compared relative to the area of the leaves */
+	double scale = 1;
+	std::mt19937_64 rng;
+
+	/* Recombined nodes in ascending order, and their curves before the move */
+	std::vector<Node> touched;
+	std::vector<std::pair<CurveHandle, uint64_t>> savedCurves;
+	/* Children and parents before the move, of the nodes it relinked */
+	std::vector<std::pair<Node, std::pair<Node, Node>>> savedChildren;
+	std::vector<std::pair<Node, Node>> savedParent;
+	double savedCost = INFINITY;
+	std::vector<char> mark;
+};
+
+struct AnnealOptions
+{
+	uint64_t seed = 1;
+	/* Stop after this many moves or seconds, whichever comes first */
+	int64_t moves = 100000;
+	double seconds = INFINITY;
+	/* Moves per temperature step, 0 for ten per leaf */
+	int movesPerTemperature = 0;
+	/* Factor of the temperature per step, 0 to end the moves at a thousandth
+		 of the initial temperature */
+	double cooling = 0;
+	/* Share of uphill moves accepted at the start */
+	double initialAcceptance = 0.9;
+	/* Samples per soft leaf */
+	int points = 1000;
+};
+
+struct AnnealResult
+{
+	double initialCost = INFINITY;
+	double bestCost = INFINITY;
+	int64_t moves = 0;
+	int64_t accepted = 0;
+	double seconds = 0;
+};
+
+/* Least area of the root curve, of the points within the outline of gst if
+	 one is set. INFINITY if no root point fits */
+inline double rootCost(Subcircuit const& root, GST const& gst)
+{
+	bool const outlined = gst.outlineW > 0 && gst.outlineH > 0;
+	VecCurve sampledX, sampledY;
+	FullCurve curve(root);
+	if (root.is_implicit && root.shapeCurveX.empty())
+	{
+		if (!outlined) return root.area;
+		sampleSoftCurve(root, sampledX, sampledY, gst.softPoints);
+		curve = FullCurve(sampledX, sampledY);
+	}
+	double best = INFINITY;
+	for (size_t k = 0; k < curve.size(); k++)
+	{
+		double w = curve.w(k), h = curve.h(k);
+		if (outlined && (w > gst.outlineW || h > gst.outlineH)) continue;
+		best = std::min(best, w * h);
+	}
+	return best;
+}
+
+/* Drop the curves of every node, so the GST can be evaluated again */
+inline void resetCurves(GST& gst)
+{
+	for (Node n = 0; n < gst.numPi; n++)
+	{
+		auto& leaf = gst.nodes[n];
+		leaf.shapeCurveX.clear();
+		leaf.shapeCurveY.clear();
+		leaf.backPtr.clear();
+		leaf.is_implicit = false;
+	}
+	for (Node n = gst.numPi; n < Node(gst.nodes.size()); n++) gst.nodes[n] = Subcircuit();
+}
+
+/* Leaf curves of gst, sampled once on its pool, to be shared by chains */
+inline std::vector<CurveHandle> shareLeaves(GST& gst, int num_points = 1000)
+{
+	gst.areaLimit.clear();
+	gst.shapeRange.clear();
+	gst.softPoints = num_points;
+	resetCurves(gst);
+	std::vector<CurveHandle> leaves(gst.numPi);
+	auto generate = [&](size_t n) {
+		generatePoints(n, gst, num_points);
+		leaves[n] = std::make_shared<Subcircuit const>(std::move(gst.nodes[n]));
+		gst.nodes[n].shapeCurveX.clear();
+		gst.nodes[n].shapeCurveY.clear();
+	};
+	if (gst.pool) gst.pool->parallelFor(gst.numPi, generate);
+	else for (Node n = 0; n < gst.numPi; n++) generate(n);
+	return leaves;
+}
+
+/* Curve of node n of the chain from the curves of its children, the one of
+	 the cache if some chain has it already. The shared child curves are
+	 combined where they are, into node 2 of the chain's GST */
+inline void combineShared(AnnealChain& chain, Node n)
+{
+	uint64_t a = chain.id[chain.leftChild[n]], b = chain.id[chain.rightChild[n]];
+	SubtreeCache::Key key(std::min(a, b), std::max(a, b));
+	auto& cache = *chain.cache;
+	{
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		auto it = cache.entries.find(key);
+		if (it != cache.entries.end())
+		{
+			if (auto shared = it->second.curve.lock())
+			{
+				chain.id[n] = it->second.id;
+				chain.curve[n] = std::move(shared);
+				return;
+			}
+		}
+	}
+
+	auto& gst = chain.gst;
+	gst.nodes[2] = Subcircuit();
+	combineNode(2, gst, *chain.curve[chain.leftChild[n]], *chain.curve[chain.rightChild[n]]);
+	auto combined = std::make_shared<Subcircuit const>(std::move(gst.nodes[2]));
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	auto inserted = cache.entries.try_emplace(key, SubtreeCache::Entry{cache.nextId, {}});
+	if (inserted.second) cache.nextId++;
+	auto& entry = inserted.first->second;
+	chain.id[n] = entry.id;
+	/* Another chain may have combined the same subtree meanwhile */
+	if (auto shared = entry.curve.lock()) chain.curve[n] = std::move(shared);
+	else
+	{
+		entry.curve = combined;
+		chain.curve[n] = std::move(combined);
+	}
+	if (cache.entries.size() >= cache.cleanAt)
+	{
+		for (auto it = cache.entries.begin(); it != cache.entries.end();)
+		{
+			if (it->second.curve.expired()) it = cache.entries.erase(it);
+			else ++it;
+		}
+		cache.cleanAt = std::max<size_t>(1 << 16, 2 * cache.entries.size());
+	}
+}
+
+/* A chain on the topology of gst, which has to be a tree, and the given
+	 leaf curves, combining through cache. The chain takes the settings of
+	 gst but runs on the calling thread */
+inline AnnealChain makeChain(GST const& gst, std::vector<CurveHandle> const& leaves, SubtreeCache& cache, uint64_t seed)
+{
+	AnnealChain chain;
+	int numNodes = gst.nodes.size();
+	chain.leftChild = gst.leftChild;
+	chain.rightChild = gst.rightChild;
+	chain.parent.assign(numNodes, -1);
+	for (Node n = gst.numPi; n < numNodes; n++)
+	{
+		assert(chain.parent[gst.leftChild[n]] < 0 && chain.parent[gst.rightChild[n]] < 0 && "Annealing needs a tree");
+		chain.parent[gst.leftChild[n]] = n;
+		chain.parent[gst.rightChild[n]] = n;
+	}
+	chain.mark.assign(numNodes, 0);
+	chain.rng.seed(seed);
+	chain.cache = &cache;
+
+	/* Settings only; nodes 0 and 1 stand for the children of a combine, whose
+		 curves are read from the cache, and 2 takes the result */
+	auto& g = chain.gst;
+	g.verbose = false;
+	g.lazySoftLeaves = gst.lazySoftLeaves;
+	g.softPoints = gst.softPoints;
+	g.symmetricHalves = gst.symmetricHalves;
+	g.prune = gst.prune;
+	g.pruneN = gst.pruneN;
+	g.pruneEpsilon = gst.pruneEpsilon;
+	g.pruneDelta = gst.pruneDelta;
+	g.outlineW = gst.outlineW;
+	g.outlineH = gst.outlineH;
+	g.recordBackPointers = false;
+	g.numPi = 2;
+	g.nodes.resize(3);
+	g.leftChild = {-1, -1, 0};
+	g.rightChild = {-1, -1, 1};
+
+	chain.curve.resize(numNodes);
+	chain.id.resize(numNodes);
+	chain.scale = 0;
+	for (Node n = 0; n < gst.numPi; n++)
+	{
+		chain.curve[n] = leaves[n];
+		chain.id[n] = n;
+		chain.scale += leaves[n]->is_hard ? leaves[n]->par1 * leaves[n]->par2 : leaves[n]->area;
+	}
+	for (Node n = gst.numPi; n < numNodes; n++) combineShared(chain, n);
+	chain.cost = rootCost(*chain.curve.back(), g);
+	return chain;
+}
+
+inline bool isAncestor(AnnealChain const& chain, Node a, Node n)
+{
+	for (Node p = chain.parent[n]; p >= 0; p = chain.parent[p])
+	{
+		if (p == a) return true;
+	}
+	return false;
+}
+
+/* Relink node n to the children l and r, remembering the old ones */
+inline void relink(AnnealChain& chain, Node n, Node l, Node r)
+{
+	chain.savedChildren.push_back({n, {chain.leftChild[n], chain.rightChild[n]}});
+	for (Node c : {l, r})
+	{
+		if (chain.parent[c] == n) continue;
+		chain.savedParent.push_back({c, chain.parent[c]});
+		chain.parent[c] = n;
+	}
+	chain.leftChild[n] = l;
+	chain.rightChild[n] = r;
+}
+
+/* Make a random move and recombine what it changed. Returns false, with
+	 nothing changed, if no valid move was found in a few tries. The move is
+	 pending until acceptMove or rejectMove */
+inline bool proposeMove(AnnealChain& chain)
+{
+	auto& left = chain.leftChild;
+	auto& right = chain.rightChild;
+	int numNodes = chain.curve.size();
+	int numPi = (numNodes + 1) / 2;
+	Node root = numNodes - 1;
+	if (numNodes < 4) return false;
+	chain.touched.clear();
+	chain.savedCurves.clear();
+	chain.savedChildren.clear();
+	chain.savedParent.clear();
+
+	std::uniform_int_distribution<Node> anyNode(0, root - 1);
+	std::vector<Node> changed;
+	for (int attempt = 0; attempt < 16 && changed.empty(); attempt++)
+	{
+		if (chain.rng() & 1)
+		{
+			Node a = anyNode(chain.rng), b = anyNode(chain.rng);
+			Node pa = chain.parent[a], pb = chain.parent[b];
+			if (pa == pb || a >= pb || b >= pa || isAncestor(chain, a, b) || isAncestor(chain, b, a)) continue;
+			relink(chain, pa, left[pa] == a ? b : left[pa], right[pa] == a ? b : right[pa]);
+			relink(chain, pb, left[pb] == b ? a : left[pb], right[pb] == b ? a : right[pb]);
+			changed = {pa, pb};
+		}
+		else
+		{
+			/* c = (x, y) under p = (c, s) becomes p = (x, c) with c = (y, s) */
+			Node c = std::uniform_int_distribution<Node>(numPi, root - 1)(chain.rng);
+			Node p = chain.parent[c];
+			Node s = left[p] == c ? right[p] : left[p];
+			bool upLeft = chain.rng() & 1;
+			Node x = upLeft ? left[c] : right[c];
+			Node y = upLeft ? right[c] : left[c];
+			if (s >= c) continue;
+			relink(chain, c, y, s);
+			relink(chain, p, x, c);
+			changed = {c};
+		}
+	}
+	if (changed.empty()) return false;
+
+	/* The relinked nodes and their ancestors, each once, in ascending order */
+	for (Node n : changed)
+	{
+		for (Node p = n; p >= 0 && !chain.mark[p]; p = chain.parent[p])
+		{
+			chain.mark[p] = 1;
+			chain.touched.push_back(p);
+		}
+	}
+	std::sort(chain.touched.begin(), chain.touched.end());
+	for (Node n : chain.touched)
+	{
+		chain.mark[n] = 0;
+		chain.savedCurves.push_back({std::move(chain.curve[n]), chain.id[n]});
+		combineShared(chain, n);
+	}
+	chain.savedCost = chain.cost;
+	chain.cost = rootCost(*chain.curve.back(), chain.gst);
+	return true;
+}
+
+inline void acceptMove(AnnealChain& chain)
+{
+	chain.savedCurves.clear();
+}
+
+/* Put back the topology and the curves from before the pending move */
+inline void rejectMove(AnnealChain& chain)
+{
+	for (size_t i = 0; i < chain.touched.size(); i++)
+	{
+		Node n = chain.touched[i];
+		chain.curve[n] = std::move(chain.savedCurves[i].first);
+		chain.id[n] = chain.savedCurves[i].second;
+	}
+	for (auto it = chain.savedChildren.rbegin(); it != chain.savedChildren.rend(); ++it)
+	{
+		chain.leftChild[it->first] = it->second.first;
+		chain.rightChild[it->first] = it->second.second;
+	}
+	for (auto it = chain.savedParent.rbegin(); it != chain.savedParent.rend(); ++it) chain.parent[it->first] = it->second;
+	chain.savedCurves.clear();
+	chain.cost = chain.savedCost;
+}
+
+/* Change of the cost of the pending move, relative to the leaf area.
+	 Leaving a tree without a root that fits the outline is the largest step
+	 up, reaching one the largest step down */
+inline double costChange(AnnealChain const& chain)
+{
+	if (chain.cost == chain.savedCost) return 0;
+	if (chain.savedCost == INFINITY) return -INFINITY;
+	return (chain.cost - chain.savedCost) / chain.scale;
+}
+
+/* Metropolis step at temperature t on the relative change of the cost.
+	 Returns whether a move was made and accepted */
+inline bool annealStep(AnnealChain& chain, double t)
+{
+	if (!proposeMove(chain)) return false;
+	double delta = costChange(chain);
+	bool accept = delta <= 0 || (t > 0 && std::uniform_real_distribution<double>(0, 1)(chain.rng) < std::exp(-delta / t));
+	if (accept) acceptMove(chain);
+	else rejectMove(chain);
+	return accept;
+}
+
+/* Temperature at which the average uphill move of a few trial moves is
+	 accepted with the given probability */
+inline double initialTemperature(AnnealChain& chain, double acceptance, int trials = 64)
+{
+	double uphill = 0;
+	int count = 0;
+	for (int i = 0; i < trials; i++)
+	{
+		if (!proposeMove(chain)) break;
+		double delta = costChange(chain);
+		rejectMove(chain);
+		if (delta > 0 && delta < INFINITY)
+		{
+			uphill += delta;
+			count++;
+		}
+	}
+	if (count == 0) return 0;
+	return -(uphill / count) / std::log(acceptance);
+}
+
+/* Anneal the topology of gst, which has to be a tree, and leave it with the
+	 best tree found, evaluated with its own settings */
+inline AnnealResult annealGST(GST& gst, AnnealOptions const& opt)
+{
+	using Clock = std::chrono::steady_clock;
+	auto start = Clock::now();
+	auto elapsed = [&]() { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+	SubtreeCache cache(gst.numPi);
+	AnnealChain chain = makeChain(gst, shareLeaves(gst, opt.points), cache, opt.seed);
+	AnnealResult result;
+	result.initialCost = result.bestCost = chain.cost;
+	std::vector<Node> bestLeft = chain.leftChild, bestRight = chain.rightChild;
+
+	int perStep = opt.movesPerTemperature > 0 ? opt.movesPerTemperature : 10 * gst.numPi;
+	double cooling = opt.cooling > 0 ? opt.cooling : std::pow(1e-3, perStep / std::max<double>(perStep, opt.moves));
+	double t = initialTemperature(chain, opt.initialAcceptance);
+	while (result.moves < opt.moves && elapsed() < opt.seconds)
+	{
+		for (int i = 0; i < perStep && result.moves < opt.moves && elapsed() < opt.seconds; i++)
+		{
+			result.moves++;
+			if (!annealStep(chain, t)) continue;
+			result.accepted++;
+			if (chain.cost < result.bestCost)
+			{
+				result.bestCost = chain.cost;
+				bestLeft = chain.leftChild;
+				bestRight = chain.rightChild;
+			}
+		}
+		t *= cooling;
+	}
+
+	gst.leftChild = std::move(bestLeft);
+	gst.rightChild = std::move(bestRight);
+	resetCurves(gst);
+	evaluateGST(gst, opt.points);
+	result.seconds = elapsed();
+	return result;
+}
+
+/* Parallel tempering: replicas of the chain at fixed temperatures, from the
+	 starting temperature of annealGST down to coldRatio times it on a
+	 geometric ladder. Every replica makes exchangeInterval moves on its own
+	 thread, then neighbouring temperatures offer to exchange their states,
+	 even pairs and odd pairs in turn, and accept with probability
+	 exp((1 / t_i - 1 / t_j) (c_i - c_j)) on costs relative to the leaf area.
+	 The replicas trade temperatures rather than trees, which is the same
+	 exchange without copying anything. Hot replicas wander and cool ones
+	 descend, and a good tree found hot makes its way down the ladder */
+struct TemperingOptions
+{
+	uint64_t seed = 1;
+	/* Replicas, 0 for one per thread of the GST's pool */
+	int replicas = 0;
+	/* Stop after this many moves per replica or seconds, whichever comes first */
+	int64_t moves = 100000;
+	double seconds = INFINITY;
+	/* Moves per replica between two rounds of exchanges */
+	int exchangeInterval = 100;
+	/* Temperature of the coldest replica as a share of the hottest's */
+	double coldRatio = 1e-3;
+	/* Share of uphill moves the hottest replica accepts */
+	double initialAcceptance = 0.9;
+	/* Samples per soft leaf */
+	int points = 1000;
+};
+
+struct TemperingResult
+{
+	double initialCost = INFINITY;
+	double bestCost = INFINITY;
+	int replicas = 0;
+	/* Over all replicas */
+	int64_t moves = 0;
+	int64_t accepted = 0;
+	int64_t exchanges = 0;
+	int64_t exchanged = 0;
+	double seconds = 0;
+};
+
+/* Whether the replicas at temperatures hot > cold with the given costs
+	 exchange. A cold replica with no root in the outline always gives its
+	 temperature to a hot one that has one */
+inline bool acceptExchange(double hot, double costHot, double cold, double costCold, double scale, double u)
+{
+	if (costHot <= costCold) return true;
+	if (costHot == INFINITY) return false;
+	return u < std::exp((1 / cold - 1 / hot) * (costCold - costHot) / scale);
+}
+
+/* Search the topology of gst, which has to be a tree, by parallel tempering
+	 on the GST's pool and leave it with the best tree of any replica,
+	 evaluated with its own settings. The leaves are sampled once and the
+	 replicas share them and their common subtrees, so the memory grows with
+	 the subtrees the replicas do not have in common rather than with their
+	 number */
+inline TemperingResult temperGST(GST& gst, TemperingOptions const& opt)
+{
+	using Clock = std::chrono::steady_clock;
+	auto start = Clock::now();
+	auto elapsed = [&]() { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+	int replicas = opt.replicas > 0 ? opt.replicas : gst.pool ? gst.pool->size() : 1;
+	SubtreeCache cache(gst.numPi);
+	std::vector<AnnealChain> chains;
+	{
+		auto leaves = shareLeaves(gst, opt.points);
+		for (int r = 0; r < replicas; r++) chains.push_back(makeChain(gst, leaves, cache, opt.seed + r));
+	}
+	TemperingResult result;
+	result.replicas = replicas;
+	result.initialCost = result.bestCost = chains[0].cost;
+	double const scale = chains[0].scale;
+
+	/* temperature[k] is the k-th hottest, replica[k] the chain running at it */
+	std::vector<double> temperature(replicas);
+	std::vector<int> replica(replicas);
+	double hottest = initialTemperature(chains[0], opt.initialAcceptance);
+	for (int k = 0; k < replicas; k++)
+	{
+		temperature[k] = hottest * std::pow(opt.coldRatio, replicas > 1 ? double(k) / (replicas - 1) : 0);
+		replica[k] = k;
+	}
+
+	struct Tally
+	{
+		int64_t moves = 0;
+		int64_t accepted = 0;
+		double bestCost = INFINITY;
+		std::vector<Node> bestLeft, bestRight;
+	};
+	std::vector<Tally> tally(replicas);
+	auto run = [&](size_t k, int64_t moves) {
+		auto& chain = chains[replica[k]];
+		auto& mine = tally[replica[k]];
+		for (int64_t i = 0; i < moves; i++)
+		{
+			mine.moves++;
+			if (!annealStep(chain, temperature[k])) continue;
+			mine.accepted++;
+			if (chain.cost < mine.bestCost && chain.cost < result.initialCost)
+			{
+				mine.bestCost = chain.cost;
+				mine.bestLeft = chain.leftChild;
+				mine.bestRight = chain.rightChild;
+			}
+		}
+	};
+
+	std::mt19937_64 rng(opt.seed);
+	int64_t done = 0;
+	int parity = 0;
+	while (done < opt.moves && elapsed() < opt.seconds)
+	{
+		int64_t moves = std::min<int64_t>(std::max(1, opt.exchangeInterval), opt.moves - done);
+		if (gst.pool) gst.pool->parallelFor(replicas, [&](size_t k) { run(k, moves); });
+		else for (int k = 0; k < replicas; k++) run(k, moves);
+		done += moves;
+
+		for (int k = parity; k + 1 < replicas; k += 2)
+		{
+			double u = std::uniform_real_distribution<double>(0, 1)(rng);
+			result.exchanges++;
+			if (!acceptExchange(temperature[k], chains[replica[k]].cost, temperature[k + 1], chains[replica[k + 1]].cost, scale, u)) continue;
+			std::swap(replica[k], replica[k + 1]);
+			result.exchanged++;
+		}
+		parity ^= 1;
+	}
+
+	int best = -1;
+	for (int r = 0; r < replicas; r++)
+	{
+		result.moves += tally[r].moves;
+		result.accepted += tally[r].accepted;
+		if (tally[r].bestCost < result.bestCost)
+		{
+			result.bestCost = tally[r].bestCost;
+			best = r;
+		}
+	}
+	if (best >= 0)
+	{
+		gst.leftChild = std::move(tally[best].bestLeft);
+		gst.rightChild = std::move(tally[best].bestRight);
+	}
+	chains.clear();
+	resetCurves(gst);
+	evaluateGST(gst, opt.points);
+	result.seconds = elapsed();
+	return result;
+}
+#pragma endregion
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "GSTrevise.hpp"
+#include <chrono>
+
+#pragma region Anytime
+/* Anytime evaluation. The whole tree is first computed with a few samples
+	 per soft leaf, which gives a root curve in a fraction of the time of a
+	 full run, and then the soft leaves are sampled finer, a few at a time,
+	 recombining only their ancestors, until a time budget runs out. The leaves
+	 refined first are the ones with the most area at stake in the shape of
+	 least area of the current root curve.
+
+	 Every curve comes with an error bound: each shape of the node, with its
+	 soft leaves taken as exact hyperbolas, has a computed point at most
+	 1 + error times as wide and as high. A soft leaf sampled at widths x_i
+	 covers the widths between x_i and x_i+1 with x_i+1, so its error is the
+	 largest ratio of two neighbouring samples minus one. Combining takes sums
+	 and maxima, which keep the larger error of the children, and pruning adds
+	 its own factor per level: 1 + pruneEpsilon for the epsilon grid and
+	 sqrt(1 + pruneDelta) for simplify. BestN drops points without a bound, so
+	 its error is infinite. Neither is the error bounded with a whitespace
+	 limit or a fixed outline: a coarse point beyond either is dropped,
+	 although a finer one next to it may be within */
+
+/* Where an anytime evaluation stands after a round. The computed shapes are
+	 all buildable, so the least root area lies between bestArea / (1 +
+	 error)^2 and bestArea */
+struct AnytimeResult
+{
+	Node root = -1;
+	/* Point of least area of the root curve, in its full indexing */
+	int bestPoint = -1;
+	double bestArea = INFINITY;
+	double error = INFINITY;
+	int rounds = 0;
+	double seconds = 0;
+	/* Every soft leaf has reached the finest sampling */
+	bool converged = false;
+
+	double areaLowerBound() const { return bestArea / ((1 + error) * (1 + error)); }
+};
+
+/* Error factor that pruning adds to a combined curve, minus one */
+inline double pruneError(GST const& gst)
+{
+	switch (gst.prune)
+	{
+	case PruneMode::EpsilonGrid: return gst.pruneEpsilon;
+	case PruneMode::Simplify: return std::sqrt(1 + gst.pruneDelta) - 1;
+	default: return INFINITY;
+	}
+}
+
+/* Error of a leaf curve as sampled. Hard leaves are exact */
+inline double leafError(Subcircuit const& leaf)
+{
+	if (leaf.is_hard) return 0;
+	double error = 0;
+	for (size_t i = 1; i < leaf.shapeCurveX.size(); i++)
+	{
+		error = std::max(error, leaf.shapeCurveX[i] / leaf.shapeCurveX[i - 1] - 1);
+	}
+	return error;
+}
+
+/* Evaluate gst in rounds until budgetSeconds have passed, starting with
+	 coarsePoints samples per soft leaf and halving the sample spacing of the
+	 leaves refined in a round, which keeps the earlier samples, up to
+	 finePoints. A round refines the soft leaves on the trace of the root
+	 point of least area whose error times area is at least half the largest
+	 one; once all of them are at finePoints, the rest of the leaves follow by
+	 the same rule, which is what brings down the error of the rest of the
+	 curve. The budget is checked between rounds, so
+	 it can be exceeded by one round. progress, if given, sees the result of
+	 every round, the coarse one included.
+
+	 The evaluation needs back-pointers for the trace and control over the
+	 samples, so it records back-pointers and samples soft leaves eagerly. A
+	 fixed outline is applied at every resolution, and an outline the coarse
+	 curves cannot fit throws like in evaluateGST */
+inline AnytimeResult anytimeGST(GST& gst, double budgetSeconds, int coarsePoints = 9, int finePoints = 1000,
+	std::function<void(AnytimeResult const&)> const& progress = {})
+{
+	using Clock = std::chrono::steady_clock;
+	auto start = Clock::now();
+	auto elapsed = [&]() { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+	gst.recordBackPointers = true;
+	gst.lazySoftLeaves = false;
+	coarsePoints = std::max(2, std::min(coarsePoints, finePoints));
+	evaluateGST(gst, coarsePoints);
+
+	int numNodes = gst.nodes.size();
+	double const prune = pruneError(gst);
+	std::vector<int> points(gst.numPi, coarsePoints);
+	std::vector<double> error(numNodes);
+	for (Node n = 0; n < gst.numPi; n++) error[n] = leafError(gst.nodes[n]);
+	auto combineError = [&](Node n) {
+		error[n] = (1 + std::max(error[gst.leftChild[n]], error[gst.rightChild[n]])) * (1 + prune) - 1;
+	};
+	for (Node n = gst.numPi; n < numNodes; n++) combineError(n);
+
+	AnytimeResult result;
+	result.root = numNodes - 1;
+	auto summarize = [&]() {
+		FullCurve curve(gst.nodes[result.root]);
+		result.bestPoint = -1;
+		result.bestArea = INFINITY;
+		for (size_t k = 0; k < curve.stored; k++)
+		{
+			double area = curve.w(k) * curve.h(k);
+			if (area < result.bestArea)
+			{
+				result.bestArea = area;
+				result.bestPoint = k;
+			}
+		}
+		result.error = error[result.root];
+		result.seconds = elapsed();
+		if (progress) progress(result);
+	};
+	summarize();
+
+	std::vector<bool> dirty(numNodes);
+	while (result.bestPoint >= 0 && elapsed() < budgetSeconds)
+	{
+		/* Soft leaves that can still be refined, those of the traced shape first */
+		auto choice = traceBack(gst, result.root, result.bestPoint);
+		std::vector<Node> candidates;
+		for (int traced = 1; traced >= 0 && candidates.empty(); traced--)
+		{
+			for (Node n = 0; n < gst.numPi; n++)
+			{
+				if (gst.nodes[n].is_hard || points[n] >= finePoints) continue;
+				if (traced && !choice[n].used) continue;
+				candidates.push_back(n);
+			}
+		}
+		if (candidates.empty())
+		{
+			result.converged = true;
+			break;
+		}
+
+		double most = 0;
+		for (Node n : candidates) most = std::max(most, error[n] * gst.nodes[n].area);
+		std::fill(dirty.begin(), dirty.end(), false);
+		for (Node n : candidates)
+		{
+			if (error[n] * gst.nodes[n].area < most / 2) continue;
+			points[n] = std::min(2 * points[n] - 1, finePoints);
+			auto& leaf = gst.nodes[n];
+			leaf.shapeCurveX.clear();
+			leaf.shapeCurveY.clear();
+			generatePoints(n, gst, points[n]);
+			error[n] = leafError(leaf);
+			dirty[n] = true;
+		}
+
+		/* Parents come after their children, so one pass recombines every
+			 ancestor of a refined leaf after both its children */
+		for (Node n = gst.numPi; n < numNodes; n++)
+		{
+			dirty[n] = dirty[gst.leftChild[n]] || dirty[gst.rightChild[n]];
+			if (!dirty[n]) continue;
+			combineNode(n, gst);
+			combineError(n);
+		}
+		if (!gst.shapeRange.empty())
+		{
+			checkOutline(gst, [&](Node n) { return gst.nodes[n].shapeCurveX.empty(); });
+		}
+		result.rounds++;
+		summarize();
+	}
+	result.seconds = elapsed();
+	return result;
+}
+#pragma endregion
@@ -0,0 +1,359 @@
+#pragma once
+
+#include "GSTrevise.hpp"
+#include <atomic>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#pragma region CompressedCurve
+/* Shape curve stored as quantized, delta encoded coordinates. Points are
+	 rounded up to multiples of quantum, so a decoded shape is never smaller
+	 than the original one. Along a curve W grows and H shrinks in small steps,
+	 so each delta is zigzag mapped and written as a LEB128 varint, which takes
+	 one or two bytes for typical curves instead of 16. Every kBlock points the
+	 absolute coordinates and byte offset go to a block index, so decoding can
+	 start at any block */
+struct CompressedCurve
+{
+	static constexpr uint32_t kBlock = 64;
+
+	struct BlockStart
+	{
+		int64_t w;
+		int64_t h;
+		uint64_t offset;
+	};
+
+	double quantum = 1e-6;
+	uint32_t size = 0;
+	std::vector<uint8_t> bytes;
+	std::vector<BlockStart> blocks;
+
+	size_t memoryBytes() const { return bytes.size() + blocks.size() * sizeof(BlockStart) + sizeof(*this); }
+};
+
+namespace curve_codec
+{
+	inline uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+	inline int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+	inline void putVarint(std::vector<uint8_t>& out, uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			out.push_back(uint8_t(v) | 0x80);
+			v >>= 7;
+		}
+		out.push_back(uint8_t(v));
+	}
+
+	inline uint64_t getVarint(uint8_t const*& p)
+	{
+		uint64_t v = 0;
+		int shift = 0;
+		while (*p & 0x80)
+		{
+			v |= uint64_t(*p++ & 0x7f) << shift;
+			shift += 7;
+		}
+		v |= uint64_t(*p++) << shift;
+		return v;
+	}
+
+	inline int64_t quantize(double v, double quantum)
+	{
+		/* The small slack keeps exact multiples from being pushed one step up */
+		return int64_t(std::ceil(v / quantum - 1e-9));
+	}
+}
+
+inline CompressedCurve compressCurve(CurveView<double> curve, double quantum)
+{
+	using namespace curve_codec;
+	CompressedCurve c;
+	c.quantum = quantum;
+	c.size = curve.size();
+	c.bytes.reserve(curve.size() * 2);
+	c.blocks.reserve((curve.size() + CompressedCurve::kBlock - 1) / CompressedCurve::kBlock);
+
+	int64_t lastW = 0, lastH = 0;
+	for (size_t i = 0; i < curve.size(); i++)
+	{
+		int64_t w = quantize(curve.w(i), quantum);
+		int64_t h = quantize(curve.h(i), quantum);
+		if (i % CompressedCurve::kBlock == 0)
+		{
+			c.blocks.push_back({w, h, c.bytes.size()});
+		}
+		else
+		{
+			putVarint(c.bytes, zigzag(w - lastW));
+			putVarint(c.bytes, zigzag(h - lastH));
+		}
+		lastW = w;
+		lastH = h;
+	}
+	c.bytes.shrink_to_fit();
+	return c;
+}
+
+/* Streaming reader over a compressed curve. next() moves to the following
+	 point and returns false once the curve is exhausted */
+struct CurveDecoder
+{
+	explicit CurveDecoder(CompressedCurve const& c, uint32_t start = 0) : c(&c)
+	{
+		seek(start);
+	}
+
+	/* Position the decoder right before point idx */
+	void seek(uint32_t idx)
+	{
+		index = idx;
+		pendingStart = false;
+		if (idx >= c->size) return;
+		uint32_t block = idx / CompressedCurve::kBlock;
+		auto const& b = c->blocks[block];
+		w = b.w;
+		h = b.h;
+		p = c->bytes.data() + b.offset;
+		for (uint32_t i = block * CompressedCurve::kBlock; i < idx; i++) step(i + 1);
+		pendingStart = true;
+	}
+
+	bool next()
+	{
+		if (pendingStart)
+		{
+			pendingStart = false;
+			return true;
+		}
+		if (index + 1 >= c->size)
+		{
+			index = c->size;
+			return false;
+		}
+		step(++index);
+		return true;
+	}
+
+	double x() const { return w * c->quantum; }
+	double y() const { return h * c->quantum; }
+
+	CompressedCurve const* c;
+	uint32_t index = 0;
+	int64_t w = 0;
+	int64_t h = 0;
+
+private:
+	void step(uint32_t i)
+	{
+		if (i % CompressedCurve::kBlock == 0)
+		{
+			auto const& b = c->blocks[i / CompressedCurve::kBlock];
+			w = b.w;
+			h = b.h;
+			p = c->bytes.data() + b.offset;
+			return;
+		}
+		w += curve_codec::unzigzag(curve_codec::getVarint(p));
+		h += curve_codec::unzigzag(curve_codec::getVarint(p));
+	}
+
+	uint8_t const* p = nullptr;
+	bool pendingStart = false;
+};
+
+inline void decompressCurve(CompressedCurve const& c, VecCurve& X, VecCurve& Y)
+{
+	X.clear();
+	Y.clear();
+	X.reserve(c.size);
+	Y.reserve(c.size);
+	CurveDecoder d(c);
+	while (d.next())
+	{
+		X.push_back(d.x());
+		Y.push_back(d.y());
+	}
+}
+
+/* Horizontal combination of two compressed curves, decoding both on the fly.
+	 Same sweep as combineNode; the result is in quantized units, so it is exact
+	 and needs no epsilon */
+inline void combineCompressed(CompressedCurve const& left, CompressedCurve const& right, VecCurve& X, VecCurve& Y,
+	std::vector<BackPointer>* backPtr = nullptr)
+{
+	assert(left.quantum == right.quantum && "Curves must share one quantum");
+	CurveDecoder l(left), r(right);
+	bool hasL = l.next(), hasR = r.next();
+	while (hasL && hasR)
+	{
+		X.push_back((l.w + r.w) * left.quantum);
+		Y.push_back(std::max(l.h, r.h) * left.quantum);
+		if (backPtr) backPtr->emplace_back(l.index, r.index);
+
+		if (l.h > r.h) hasL = l.next();
+		else if (r.h > l.h) hasR = r.next();
+		else {
+			hasL = l.next();
+			hasR = r.next();
+		}
+	}
+}
+
+/* Compress the curves of every node and release the raw ones. Back-pointers
+	 are kept as they are */
+inline std::vector<CompressedCurve> compressGST(GST& gst, double quantum)
+{
+	std::vector<CompressedCurve> curves(gst.nodes.size());
+	for (size_t n = 0; n < gst.nodes.size(); n++)
+	{
+		auto& node = gst.nodes[n];
+		curves[n] = compressCurve(curveView(node), quantum);
+		VecCurve().swap(node.shapeCurveX);
+		VecCurve().swap(node.shapeCurveY);
+	}
+	return curves;
+}
+
+/* Evaluate gst like evaluateGST, compressing the curve of every node as
+	 soon as all its parents are combined, so only the curves that are still
+	 to be combined are held as doubles. Returns the compressed curves,
+	 indexed by node; the roots keep their raw curves and an empty entry.
+	 Back-pointers are kept, and decompressCurves brings the curves back for
+	 traceBack and realizePlacement. With back-pointers the leaves and the
+	 nodes combined in closed form keep their raw curves too: a placement
+	 reports their points as the shapes of the modules */
+inline std::vector<CompressedCurve> evaluateCompressed(GST& gst, double quantum, int num_points = 1000)
+{
+	int numNodes = gst.nodes.size();
+	std::vector<CompressedCurve> curves(numNodes);
+	std::unique_ptr<std::atomic<int>[]> parentsLeft(new std::atomic<int>[numNodes]);
+	for (Node n = 0; n < numNodes; n++) parentsLeft[n] = 0;
+	for (Node n = gst.numPi; n < numNodes; n++)
+	{
+		parentsLeft[gst.leftChild[n]]++;
+		parentsLeft[gst.rightChild[n]]++;
+	}
+
+	gst.softPoints = num_points;
+	if (gst.whitespace >= 0) gst.areaLimit = areaLimits(gst);
+	if (gst.outlineW > 0 && gst.outlineH > 0) gst.shapeRange = shapeRanges(gst);
+	scheduleGST(gst, gst.pool, [&](Node n) { generatePoints(n, gst, num_points); }, [&](Node n) {
+		combineNode(n, gst);
+		for (Node child : {gst.leftChild[n], gst.rightChild[n]})
+		{
+			if (parentsLeft[child].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+			if (gst.recordBackPointers && (child < gst.numPi || gst.nodes[child].is_implicit)) continue;
+			auto& node = gst.nodes[child];
+			curves[child] = compressCurve(curveView(node), quantum);
+			VecCurve().swap(node.shapeCurveX);
+			VecCurve().swap(node.shapeCurveY);
+		}
+	});
+	if (!gst.shapeRange.empty())
+	{
+		checkOutline(gst, [&](Node n) {
+			return gst.nodes[n].shapeCurveX.empty() && curves[n].size == 0 && !gst.nodes[n].is_implicit;
+		});
+	}
+	return curves;
+}
+
+/* Put the compressed curves back into the nodes that hold none. The decoded
+	 points are rounded up, so a point combined from the exact children would
+	 be smaller than the box its trace realizes. With back-pointers every
+	 combined point, the roots' included, is therefore rebuilt from the child
+	 points it refers to, children first, which from the raw leaves of
+	 evaluateCompressed gives back the exact curves */
+inline void decompressCurves(GST& gst, std::vector<CompressedCurve> const& curves)
+{
+	for (size_t n = 0; n < curves.size(); n++)
+	{
+		auto& node = gst.nodes[n];
+		if (curves[n].size > 0 && node.shapeCurveX.empty()) decompressCurve(curves[n], node.shapeCurveX, node.shapeCurveY);
+	}
+	if (!gst.recordBackPointers) return;
+	for (Node n = gst.numPi; n < Node(gst.nodes.size()); n++)
+	{
+		auto& node = gst.nodes[n];
+		if (node.backPtr.size() != node.shapeCurveX.size()) continue;
+		FullCurve L(gst.nodes[gst.leftChild[n]]), R(gst.nodes[gst.rightChild[n]]);
+		for (size_t k = 0; k < node.backPtr.size(); k++)
+		{
+			auto const& bp = node.backPtr[k];
+			double w = L.w(bp.leftIdx()) + R.w(bp.rightIdx());
+			double h = std::max(L.h(bp.leftIdx()), R.h(bp.rightIdx()));
+			node.shapeCurveX[k] = bp.isVertical() ? h : w;
+			node.shapeCurveY[k] = bp.isVertical() ? w : h;
+		}
+	}
+}
+
+/* Binary dump: "GSTC", quantum, point count, block count, the block index and
+	 the encoded bytes, written as they sit in memory */
+inline void writeCompressedCurve(std::ostream& os, CompressedCurve const& c)
+{
+	uint64_t blocks = c.blocks.size(), bytes = c.bytes.size();
+	os.write("GSTC", 4);
+	os.write(reinterpret_cast<char const*>(&c.quantum), sizeof(c.quantum));
+	os.write(reinterpret_cast<char const*>(&c.size), sizeof(c.size));
+	os.write(reinterpret_cast<char const*>(&blocks), sizeof(blocks));
+	os.write(reinterpret_cast<char const*>(&bytes), sizeof(bytes));
+	os.write(reinterpret_cast<char const*>(c.blocks.data()), blocks * sizeof(CompressedCurve::BlockStart));
+	os.write(reinterpret_cast<char const*>(c.bytes.data()), bytes);
+}
+
+inline CompressedCurve readCompressedCurve(std::istream& is)
+{
+	char magic[4];
+	is.read(magic, 4);
+	if (!is || std::string(magic, 4) != "GSTC") throw std::runtime_error("Not a compressed curve");
+
+	CompressedCurve c;
+	uint64_t blocks = 0, bytes = 0;
+	is.read(reinterpret_cast<char*>(&c.quantum), sizeof(c.quantum));
+	is.read(reinterpret_cast<char*>(&c.size), sizeof(c.size));
+	is.read(reinterpret_cast<char*>(&blocks), sizeof(blocks));
+	is.read(reinterpret_cast<char*>(&bytes), sizeof(bytes));
+	if (!is) throw std::runtime_error("Truncated compressed curve");
+	if (blocks != (uint64_t(c.size) + CompressedCurve::kBlock - 1) / CompressedCurve::kBlock)
+		throw std::runtime_error("Compressed curve has a block count that does not match its point count");
+	/* Checked before anything is allocated: every point after the first of a
+		 block takes two varints of one to ten bytes each */
+	uint64_t deltas = c.size - blocks;
+	if (bytes < 2 * deltas || bytes > 20 * deltas)
+		throw std::runtime_error("Compressed curve has a byte count that does not match its point count");
+	c.blocks.resize(blocks);
+	c.bytes.resize(bytes);
+	is.read(reinterpret_cast<char*>(c.blocks.data()), blocks * sizeof(CompressedCurve::BlockStart));
+	is.read(reinterpret_cast<char*>(c.bytes.data()), bytes);
+	if (!is) throw std::runtime_error("Truncated compressed curve");
+	if (!(c.quantum > 0)) throw std::runtime_error("Compressed curve has a quantum that is not positive");
+
+	/* Blocks start in order, each one after the deltas of the block before,
+		 and the varints of a block may not run past the next block's start */
+	for (uint64_t b = 0; b < blocks; b++)
+	{
+		uint64_t count = std::min<uint64_t>(CompressedCurve::kBlock, c.size - b * CompressedCurve::kBlock);
+		uint64_t end = b + 1 < blocks ? c.blocks[b + 1].offset : bytes;
+		if ((b == 0 && c.blocks[b].offset != 0) || c.blocks[b].offset > end || end - c.blocks[b].offset < 2 * (count - 1))
+			throw std::runtime_error("Compressed curve has a block offset out of range");
+		uint64_t pos = c.blocks[b].offset;
+		for (uint64_t v = 0; v < 2 * (count - 1); v++)
+		{
+			int length = 1;
+			while (pos < end && (c.bytes[pos] & 0x80))
+			{
+				pos++;
+				if (++length > 10) throw std::runtime_error("Compressed curve has a varint that is too long");
+			}
+			if (pos++ >= end) throw std::runtime_error("Compressed curve has a block that runs past its end");
+		}
+		if (pos != end) throw std::runtime_error("Compressed curve has bytes between its blocks");
+	}
+	return c;
+}
+#pragma endregion
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "GSTrevise.hpp"
+#include <limits>
+
+#pragma region DatabaseUnits
+/* Integer coordinate mode. Every dimension is a whole number of grid units
+	 and stored as an Int, int32_t or int64_t. Leaf shapes are rounded up to
+	 the grid, so each shape stays buildable, and from there on combining only
+	 adds and takes maxima, which is exact. Points that are equal really are
+	 equal: duplicates collapse the same way on every run and the sweeps need
+	 no epsilon. int32 curves also take half the memory of double ones, and
+	 twice as many coordinates fit a vector register */
+struct DbuGrid
+{
+	explicit DbuGrid(double unit = 1e-3) : unit(unit) {}
+
+	/* Round up to the grid; the slack keeps exact multiples where they are */
+	template<typename Int>
+	Int toDbu(double v) const { return Int(std::ceil(v / unit - 1e-9)); }
+	double toUser(int64_t v) const { return v * unit; }
+
+	double unit;
+};
+
+template<typename Int>
+struct DbuCurve
+{
+	ShapeCurve<Int> curve;
+	std::vector<BackPointer> backPtr;
+	int level = 0;
+};
+
+/* Whether the curves of gst fit int32 units. No combined dimension exceeds
+	 the sum of the largest dimensions of the leaves */
+inline bool fitsInt32(GST const& gst, DbuGrid const& grid)
+{
+	double bound = 0;
+	for (Node n = 0; n < gst.numPi; n++)
+	{
+		auto const& leaf = gst.nodes[n];
+		if (leaf.is_hard) bound += std::max(leaf.par1, leaf.par2);
+		else bound += std::max(std::sqrt(leaf.area / leaf.par1), std::sqrt(leaf.area * leaf.par2));
+		bound += 2 * grid.unit;
+	}
+	return bound / grid.unit < std::numeric_limits<int32_t>::max();
+}
+
+/* Leaf curve on the grid. Soft leaves are sampled like in generatePoints and
+	 rounded toward the inside of their aspect bounds: each width up to the
+	 grid but not past the widest the bounds allow, and its height up to cover
+	 the area and the least aspect. A point whose height would pass the
+	 greatest aspect is dropped, and widths that round to the same unit leave
+	 only their lowest point. A leaf of a few units may have no grid shape
+	 within its bounds at all; its shapes are rounded up regardless. A range,
+	 in user units, clips the curve like in generatePoints */
+template<typename Int>
+void generateDbu(Subcircuit const& leaf, DbuGrid const& grid, int num_points, DbuCurve<Int>& out,
+	ShapeCurveRange const* range = nullptr)
+{
+	GST_PROFILE_SCOPE(ProfilePhase::LeafGeneration, 0);
+	auto& c = out.curve;
+	if (leaf.is_hard)
+	{
+		Int w = grid.toDbu<Int>(std::min(leaf.par1, leaf.par2));
+		Int h = grid.toDbu<Int>(std::max(leaf.par1, leaf.par2));
+		c.push_back(w, h);
+		if (w != h) c.push_back(h, w);
+		if (range) clipToRange(c.widths(), c.heights(), range->scaled(1 / grid.unit));
+		return;
+	}
+	VecCurve X, Y;
+	sampleSoftCurve(leaf, X, Y, num_points, range);
+	double area = leaf.area / (grid.unit * grid.unit);
+	double const slack = 1e-9;
+	Int wMin = std::max<Int>(1, Int(std::ceil(std::sqrt(area / leaf.par2) - slack)));
+	Int wMax = Int(std::floor(std::sqrt(area / leaf.par1) + slack));
+	c.reserve(X.size());
+	for (double x : X)
+	{
+		if (wMin > wMax) break;
+		Int w = std::clamp(grid.toDbu<Int>(x), wMin, wMax);
+		Int h = Int(std::ceil(std::max(area / w, leaf.par1 * w) - slack));
+		if (h <= std::floor(leaf.par2 * w + slack)) c.push_back(w, h);
+	}
+	if (c.empty())
+	{
+		for (double x : X)
+		{
+			Int w = grid.toDbu<Int>(x);
+			c.push_back(w, Int(std::ceil(area / w - 1e-9)));
+		}
+	}
+	paretoFilter(c.widths(), c.heights());
+	if (range) clipToRange(c.widths(), c.heights(), range->scaled(1 / grid.unit));
+}
+
+/* Combine and flip two integer curves, the counterpart of combineNode and
+	 flipCurve. The sweep writes every step to a buffer that fits them all and
+	 only moves the write position past points lower than the one before, so
+	 neither advancing the children nor dropping dominated positions takes a
+	 branch. The area limit and the range, both in grid units, are applied
+	 like in combineNode */
+template<typename Int>
+void combineDbu(DbuCurve<Int> const& left, DbuCurve<Int> const& right, GST const& gst, DbuCurve<Int>& out,
+	double areaLimit = INFINITY, ShapeCurveRange const* range = nullptr)
+{
+	out.level = std::max(left.level, right.level) + 1;
+	GST_PROFILE_SCOPE(ProfilePhase::Combine, out.level);
+	Int const* LX = left.curve.widths().data();
+	Int const* LY = left.curve.heights().data();
+	Int const* RX = right.curve.widths().data();
+	Int const* RY = right.curve.heights().data();
+	size_t lsize = left.curve.size();
+	size_t rsize = right.curve.size();
+	bool const tracked = gst.recordBackPointers;
+
+	std::vector<Int> X(lsize + rsize), Y(lsize + rsize);
+	std::vector<BackPointer> backPtr(tracked ? lsize + rsize : 0);
+	size_t li = 0, ri = 0, size = 0;
+	Int lastH = std::numeric_limits<Int>::max();
+	while (li < lsize && ri < rsize)
+	{
+		Int lh = LY[li], rh = RY[ri];
+		Int h = std::max(lh, rh);
+		X[size] = LX[li] + RX[ri];
+		Y[size] = h;
+		if (tracked) backPtr[size] = BackPointer(li, ri);
+		size += h < lastH;
+		lastH = h;
+		bool leftFirst = lh >= rh;
+		li += leftFirst;
+		ri += !leftFirst;
+	}
+
+	X.resize(size);
+	Y.resize(size);
+	if (tracked) backPtr.resize(size);
+	if (areaLimit < INFINITY) pruneAreaAbove(X, Y, areaLimit, tracked ? &backPtr : nullptr);
+	if (range) clipToRange(X, Y, *range, true, tracked ? &backPtr : nullptr);
+	size = X.size();
+
+	GST_PROFILE_SCOPE(ProfilePhase::Flip, out.level);
+	/* Flipped point t comes from point size - 1 - t, originals go first on ties */
+	out.curve.resize(2 * size);
+	auto& W = out.curve.widths();
+	auto& H = out.curve.heights();
+	std::vector<BackPointer> flipped(tracked ? 2 * size : 0);
+	size_t i = 0, t = 0;
+	for (size_t k = 0; k < 2 * size; k++)
+	{
+		if (t == size || (i < size && X[i] <= Y[size - 1 - t]))
+		{
+			W[k] = X[i];
+			H[k] = Y[i];
+			if (tracked) flipped[k] = backPtr[i];
+			i++;
+		}
+		else
+		{
+			size_t j = size - 1 - t;
+			W[k] = Y[j];
+			H[k] = X[j];
+			if (tracked) flipped[k] = BackPointer(backPtr[j].leftIdx(), backPtr[j].rightIdx(), true);
+			t++;
+		}
+	}
+	if (range) clipToRange(W, H, *range, false, tracked ? &flipped : nullptr);
+	pruneCurve(gst, W, H, tracked ? &flipped : nullptr);
+	out.backPtr = std::move(flipped);
+}
+
+/* Curves of every node in grid units, computed on the GST's pool with the
+	 GST's pruning, whitespace budget and outline. Soft leaves are always
+	 sampled here; implicit leaves and half curves are features of the double
+	 mode */
+template<typename Int>
+std::vector<DbuCurve<Int>> evaluateDbu(GST const& gst, DbuGrid const& grid, int num_points = 1000)
+{
+	std::vector<DbuCurve<Int>> curves(gst.nodes.size());
+	std::vector<double> limit = gst.whitespace >= 0 ? areaLimits(gst) : std::vector<double>();
+	std::vector<ShapeCurveRange> range = gst.outlineW > 0 && gst.outlineH > 0 ? shapeRanges(gst) : std::vector<ShapeCurveRange>();
+	double const unitArea = grid.unit * grid.unit;
+	scheduleGST(gst, gst.pool,
+		[&](Node n) { generateDbu(gst.nodes[n], grid, num_points, curves[n], range.empty() ? nullptr : &range[n]); },
+		[&](Node n) {
+			double areaLimit = limit.empty() ? INFINITY : limit[n] / unitArea;
+			ShapeCurveRange box;
+			if (!range.empty()) box = range[n].scaled(1 / grid.unit);
+			combineDbu(curves[gst.leftChild[n]], curves[gst.rightChild[n]], gst, curves[n], areaLimit,
+				range.empty() ? nullptr : &box);
+		});
+	if (!range.empty()) checkOutline(gst, [&](Node n) { return curves[n].curve.empty(); });
+	return curves;
+}
+
+/* Move the curves into the GST in user units, where traceBack,
+	 realizePlacement and the writers read them */
+template<typename Int>
+void exportDbu(std::vector<DbuCurve<Int>>& curves, DbuGrid const& grid, GST& gst)
+{
+	for (Node n = 0; n < Node(gst.nodes.size()); n++)
+	{
+		auto& node = gst.nodes[n];
+		auto& c = curves[n];
+		node.shapeCurveX.resize(c.curve.size());
+		node.shapeCurveY.resize(c.curve.size());
+		for (size_t i = 0; i < c.curve.size(); i++)
+		{
+			node.shapeCurveX[i] = grid.toUser(c.curve.w(i));
+			node.shapeCurveY[i] = grid.toUser(c.curve.h(i));
+		}
+		node.backPtr = std::move(c.backPtr);
+		node.level = c.level;
+		node.is_implicit = false;
+		node.is_symmetric = false;
+		c.curve = ShapeCurve<Int>();
+	}
+}
+#pragma endregion
@@ -0,0 +1,390 @@
+#include "GSTanneal.hpp"
+#include "GSTanytime.hpp"
+#include "GSTcompress.hpp"
+#include "GSTdbu.hpp"
+#include "GSTio.hpp"
+#include "GSTplacement.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+/* Command line driver: reads a module list and a partition, computes the
+	 root curve and writes it, optionally with the floorplan of its point of
+	 least area. Meant to be run from scripts, it never prompts */
+
+void usage(char const* prog)
+{
+	std::cerr<<"usage: "<<prog<<" MODULES PARTITION [options]\n"
+		<<"  --threads N           worker threads from 1 to 1024, 1 runs on the calling thread only (default: all cores)\n"
+		<<"  --points N            samples per soft leaf (default: 1000)\n"
+		<<"  --prune best[:N]      keep the N points of least area (default, N = 1000)\n"
+		<<"  --prune epsilon[:E]   epsilon-dominance grid with ratio 1 + E (E = 0.01)\n"
+		<<"  --prune simplify[:D]  fewest points that lose at most 1 + D in area (D = 0.01)\n"
+		<<"  --backend eager|lazy  sample soft leaves up front, or keep them implicit (default: eager)\n"
+		<<"  --storage full|half   store combined curves whole, or only their w <= h half (default: full)\n"
+		<<"  --whitespace W        drop shapes that cannot reach a root of at most 1 + W times the leaf area\n"
+		<<"  --outline W:H         fixed outline the root has to fit (default: off)\n"
+		<<"  --budget MS           start coarse and refine for MS milliseconds, eager backend with epsilon\n"
+		<<"                        or simplify pruning, whose error is bounded, and without whitespace\n"
+		<<"                        or outline (default: off)\n"
+		<<"  --anneal MOVES        anneal the tree topology for MOVES moves before evaluating (default: off)\n"
+		<<"  --replicas N          anneal by parallel tempering with N replicas on the threads, MOVES each (default: off)\n"
+		<<"  --tree FILE           partition of the evaluated tree, after annealing\n"
+		<<"  --compress Q          keep combined-away curves delta encoded on a grid of Q (default: off)\n"
+		<<"  --dbu UNIT            compute in integer multiples of UNIT, eager backend and full storage only.\n"
+		<<"                        Soft leaves keep their aspect bounds, except ones too small for any\n"
+		<<"                        shape on the grid to fit them, which may end up slightly outside (default: off)\n"
+		<<"  --format text|binary  format of the outputs (default: text)\n"
+		<<"  --output FILE         root curve, '-' for stdout (default: -)\n"
+		<<"  --placement FILE      floorplan of the root point of least area\n";
+}
+
+struct Options
+{
+	std::string modules;
+	std::string partition;
+	unsigned threads = std::thread::hardware_concurrency();
+	int points = 1000;
+	PruneMode prune = PruneMode::BestN;
+	int pruneN = 1000;
+	double pruneEpsilon = 0.01;
+	double pruneDelta = 0.01;
+	bool lazy = false;
+	bool half = false;
+	double dbu = 0;
+	double compress = 0;
+	double whitespace = -1;
+	double outlineW = 0;
+	double outlineH = 0;
+	double budget = 0;
+	int64_t anneal = 0;
+	int replicas = 0;
+	std::string tree;
+	bool binary = false;
+	std::string output = "-";
+	std::string placement;
+};
+
+/* More workers than this is a typo rather than a machine */
+constexpr int kMaxThreads = 1024;
+
+/* Parse argv into opt. Returns false, after printing why, on bad arguments */
+bool parseArgs(int argc, char** argv, Options& opt)
+{
+	std::vector<std::string> positional;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg.rfind("--", 0) != 0)
+		{
+			positional.push_back(arg);
+			continue;
+		}
+		if (i + 1 >= argc)
+		{
+			std::cerr<<"missing value for "<<arg<<"\n";
+			return false;
+		}
+		std::string value = argv[++i];
+		/* Only these take a second value after a ':', paths are kept whole */
+		std::string param;
+		size_t colon = value.find(':');
+		if ((arg == "--prune" || arg == "--outline") && colon != std::string::npos)
+		{
+			param = value.substr(colon + 1);
+			value.erase(colon);
+		}
+		try
+		{
+			if (arg == "--threads")
+			{
+				/* Parsed signed, so "-1" is not taken for a huge count */
+				int threads = std::stoi(value);
+				if (threads < 1 || threads > kMaxThreads) throw std::out_of_range("threads");
+				opt.threads = threads;
+			}
+			else if (arg == "--points") opt.points = std::stoi(value);
+			else if (arg == "--prune" && value == "best")
+			{
+				opt.prune = PruneMode::BestN;
+				if (!param.empty()) opt.pruneN = std::stoi(param);
+			}
+			else if (arg == "--prune" && value == "epsilon")
+			{
+				opt.prune = PruneMode::EpsilonGrid;
+				if (!param.empty()) opt.pruneEpsilon = std::stod(param);
+			}
+			else if (arg == "--prune" && value == "simplify")
+			{
+				opt.prune = PruneMode::Simplify;
+				if (!param.empty()) opt.pruneDelta = std::stod(param);
+			}
+			else if (arg == "--backend" && (value == "eager" || value == "lazy")) opt.lazy = value == "lazy";
+			else if (arg == "--dbu") opt.dbu = std::stod(value);
+			else if (arg == "--compress") opt.compress = std::stod(value);
+			else if (arg == "--whitespace") opt.whitespace = std::stod(value);
+			else if (arg == "--budget") opt.budget = std::stod(value);
+			else if (arg == "--anneal") opt.anneal = std::stoll(value);
+			else if (arg == "--replicas") opt.replicas = std::stoi(value);
+			else if (arg == "--tree") opt.tree = value;
+			else if (arg == "--outline" && !param.empty())
+			{
+				opt.outlineW = std::stod(value);
+				opt.outlineH = std::stod(param);
+			}
+			else if (arg == "--storage" && (value == "full" || value == "half")) opt.half = value == "half";
+			else if (arg == "--format" && (value == "text" || value == "binary")) opt.binary = value == "binary";
+			else if (arg == "--output") opt.output = value;
+			else if (arg == "--placement") opt.placement = value;
+			else
+			{
+				std::cerr<<"unknown option "<<arg<<" "<<argv[i]<<"\n";
+				return false;
+			}
+		}
+		catch (std::exception const&)
+		{
+			std::cerr<<"bad value for "<<arg<<": "<<argv[i]<<"\n";
+			return false;
+		}
+	}
+	auto reject = [](char const* why) {
+		std::cerr<<why<<"\n";
+		return false;
+	};
+	if (positional.size() != 2) return reject("expected a module list and a partition");
+	if (opt.points < 2 || opt.pruneN < 1 || opt.pruneEpsilon <= 0 || opt.pruneDelta <= 0 || opt.dbu < 0 || opt.compress < 0
+		|| opt.outlineW < 0 || opt.outlineH < 0 || opt.budget < 0 || opt.anneal < 0 || opt.replicas < 0)
+	{
+		return reject("points, prune size, epsilon, delta, dbu, compress and outline must be positive");
+	}
+	if (opt.dbu > 0 && (opt.lazy || opt.half)) return reject("dbu evaluation needs the eager backend with full storage");
+	if (opt.budget > 0 && (opt.dbu > 0 || opt.lazy)) return reject("the budget needs the eager backend without dbu");
+	if (opt.budget > 0 && opt.prune == PruneMode::BestN)
+	{
+		return reject("the budget needs --prune epsilon or simplify, best-N pruning has no error bound");
+	}
+	if (opt.budget > 0 && (opt.whitespace >= 0 || opt.outlineW > 0))
+	{
+		return reject("the budget cannot bound the shapes dropped by --whitespace or --outline");
+	}
+	if (opt.anneal > 0 && (opt.dbu > 0 || opt.budget > 0)) return reject("annealing needs the double backend without a budget");
+	if (opt.replicas > 0 && opt.anneal == 0) return reject("replicas need --anneal for the moves each one makes");
+	if (opt.compress > 0 && (opt.dbu > 0 || opt.budget > 0 || opt.anneal > 0))
+	{
+		return reject("compression applies to a plain evaluation, without dbu, budget or annealing");
+	}
+	opt.modules = positional[0];
+	opt.partition = positional[1];
+	return true;
+}
+
+/* Root curve as "w h" lines, or "GSTR", the point count as uint64 and the
+	 (w, h) pairs as doubles */
+void writeCurve(std::ostream& os, CurveView<double> curve, bool binary)
+{
+	if (binary)
+	{
+		uint64_t count = curve.size();
+		os.write("GSTR", 4);
+		os.write(reinterpret_cast<char const*>(&count), sizeof(count));
+		for (auto p : curve)
+		{
+			os.write(reinterpret_cast<char const*>(&p.w), sizeof(double));
+			os.write(reinterpret_cast<char const*>(&p.h), sizeof(double));
+		}
+		return;
+	}
+	os<<std::setprecision(17);
+	for (auto p : curve) os<<p.w<<" "<<p.h<<"\n";
+}
+
+/* Write a file through write(os). Prints the path and returns false if it
+	 cannot be opened or written */
+template<typename Write>
+bool writeFile(std::string const& path, bool binary, Write&& write)
+{
+	std::ofstream os(path, binary ? std::ios::binary : std::ios::out);
+	if (!os.is_open())
+	{
+		std::cerr<<"cannot open "<<path<<" for writing\n";
+		return false;
+	}
+	write(os);
+	os.close();
+	if (!os)
+	{
+		std::cerr<<"error writing "<<path<<"\n";
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!parseArgs(argc, argv, opt))
+	{
+		usage(argv[0]);
+		return 2;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	std::vector<std::pair<char const*, double>> timing;
+	auto lap = [&, last = Clock::now()](char const* phase) mutable {
+		auto now = Clock::now();
+		timing.emplace_back(phase, std::chrono::duration<double>(now - last).count());
+		last = now;
+	};
+
+	GST gst;
+	gst.verbose = false;
+	gst.lazySoftLeaves = opt.lazy;
+	gst.prune = opt.prune;
+	gst.pruneN = opt.pruneN;
+	gst.pruneEpsilon = opt.pruneEpsilon;
+	gst.pruneDelta = opt.pruneDelta;
+	gst.symmetricHalves = opt.half;
+	gst.whitespace = opt.whitespace;
+	gst.outlineW = opt.outlineW;
+	gst.outlineH = opt.outlineH;
+	gst.recordBackPointers = !opt.placement.empty();
+	std::unique_ptr<WorkStealingPool> pool;
+	if (opt.threads > 1) pool = std::make_unique<WorkStealingPool>(opt.threads);
+	gst.pool = pool.get();
+	try
+	{
+		readModules(opt.modules, gst, gst.pool);
+		readPartition(opt.partition, gst, gst.pool);
+		if (gst.numPi < 2 || gst.nodes.size() != size_t(2 * gst.numPi - 1))
+			throw std::runtime_error("partition must have one line less than there are modules");
+	}
+	catch (std::exception const& e)
+	{
+		std::cerr<<e.what()<<"\n";
+		return 1;
+	}
+	lap("read");
+
+	Node root = gst.nodes.size() - 1;
+	std::vector<CompressedCurve> compressed;
+	try
+	{
+		if (opt.dbu > 0)
+		{
+			DbuGrid grid(opt.dbu);
+			if (fitsInt32(gst, grid))
+			{
+				auto curves = evaluateDbu<int32_t>(gst, grid, opt.points);
+				exportDbu(curves, grid, gst);
+			}
+			else
+			{
+				auto curves = evaluateDbu<int64_t>(gst, grid, opt.points);
+				exportDbu(curves, grid, gst);
+			}
+		}
+		else if (opt.budget > 0)
+		{
+			auto result = anytimeGST(gst, opt.budget / 1000, 9, opt.points, [](AnytimeResult const& r) {
+				std::cerr<<"round "<<r.rounds<<" at "<<std::fixed<<std::setprecision(3)<<r.seconds<<" s: area "
+					<<std::defaultfloat<<std::setprecision(8)<<r.bestArea<<", at least "<<r.areaLowerBound()<<"\n";
+			});
+			if (result.converged) std::cerr<<"converged after "<<result.rounds<<" rounds\n";
+		}
+		else if (opt.anneal > 0 && opt.replicas > 0)
+		{
+			TemperingOptions tempering;
+			tempering.replicas = opt.replicas;
+			tempering.moves = opt.anneal;
+			tempering.points = opt.points;
+			auto result = temperGST(gst, tempering);
+			std::cerr<<"tempered "<<result.replicas<<" replicas, "<<result.moves<<" moves, "<<result.accepted<<" accepted, "
+				<<result.exchanged<<" of "<<result.exchanges<<" exchanges: area "<<result.initialCost<<" -> "<<result.bestCost<<"\n";
+		}
+		else if (opt.anneal > 0)
+		{
+			AnnealOptions anneal;
+			anneal.moves = opt.anneal;
+			anneal.points = opt.points;
+			auto result = annealGST(gst, anneal);
+			std::cerr<<"annealed "<<result.moves<<" moves, "<<result.accepted<<" accepted: area "
+				<<result.initialCost<<" -> "<<result.bestCost<<"\n";
+		}
+		else if (opt.compress > 0)
+		{
+			/* Decoded before anything is written, so the root curve is the one
+				 the placement realizes */
+			compressed = evaluateCompressed(gst, opt.compress, opt.points);
+			if (gst.recordBackPointers) decompressCurves(gst, compressed);
+		}
+		else evaluateGST(gst, opt.points);
+		materializeImplicit(root, gst, opt.points);
+		expandSymmetric(root, gst);
+		if (gst.nodes[root].shapeCurveX.empty())
+		{
+			if (gst.outlineW > 0) throw std::runtime_error("no root shape fits the outline");
+			if (gst.whitespace >= 0) throw std::runtime_error("no root shape is within the whitespace budget");
+			throw std::runtime_error("internal error: the root has no shape");
+		}
+	}
+	catch (std::exception const& e)
+	{
+		std::cerr<<e.what()<<"\n";
+		return 1;
+	}
+	lap("evaluate");
+
+	if (!opt.tree.empty() && !writeFile(opt.tree, false, [&](std::ostream& os) { writePartition(os, gst); })) return 1;
+
+	auto const& rootNode = gst.nodes[root];
+	if (opt.output == "-")
+	{
+		writeCurve(std::cout, curveView(rootNode), opt.binary);
+		if (!std::cout.flush())
+		{
+			std::cerr<<"error writing the curve to stdout\n";
+			return 1;
+		}
+	}
+	else if (!writeFile(opt.output, opt.binary, [&](std::ostream& os) { writeCurve(os, curveView(rootNode), opt.binary); })) return 1;
+	lap("write curve");
+
+	if (!opt.placement.empty())
+	{
+		int best = 0;
+		for (size_t i = 1; i < rootNode.shapeCurveX.size(); i++)
+		{
+			if (rootNode.shapeCurveX[i] * rootNode.shapeCurveY[i] < rootNode.shapeCurveX[best] * rootNode.shapeCurveY[best]) best = i;
+		}
+		auto rects = realizePlacement(gst, root, best);
+		lap("placement");
+		bool written = writeFile(opt.placement, opt.binary, [&](std::ostream& os) {
+			if (opt.binary) writePlacementBinary(os, rects);
+			else writePlacementCSV(os, rects);
+		});
+		if (!written) return 1;
+		lap("write placement");
+	}
+
+	double total = 0;
+	std::cerr<<"modules "<<gst.numPi<<", root points "<<rootNode.shapeCurveX.size()<<"\n";
+	if (!compressed.empty())
+	{
+		size_t bytes = 0, raw = 0;
+		for (auto const& c : compressed)
+		{
+			bytes += c.memoryBytes();
+			raw += c.size * 2 * sizeof(double);
+		}
+		std::cerr<<"compressed curves "<<bytes<<" bytes, "<<raw<<" as doubles\n";
+	}
+	for (auto const& t : timing)
+	{
+		std::cerr<<std::left<<std::setw(16)<<t.first<<std::right<<std::fixed<<std::setprecision(3)<<t.second<<" s\n";
+		total += t.second;
+	}
+	std::cerr<<std::left<<std::setw(16)<<"total"<<std::right<<total<<" s\n";
+	return 0;
+}
@@ -0,0 +1,701 @@
+#include "GSTcompress.hpp"
+#include "GSTdbu.hpp"
+#include "GSTgenerator.hpp"
+#include "GSTplacement.hpp"
+#include "PointsCurve.hpp"
+#include "SlicingTreeArena.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+/* Differential fuzzer and performance check of the curve operators. Every
+	 kernel is run on random staircases and compared against a brute force
+	 reference: all pairs of child points, their transposes, and a Pareto
+	 filter. A kernel is equivalent if its output has the same Pareto front
+	 as the reference. Soft modules of the lazy backend are checked on pairs
+	 of leaves instead, against exact shapes of the modules. The timing pass
+	 measures every kernel on large curves and compares its time per input
+	 point, relative to the one of combineNode, against a stored baseline,
+	 GSTfuzz.baseline unless another file is given. The ratios hold from one
+	 machine to the next where absolute times would not; the sliced kernels
+	 run on four workers, so they compare alike on machines with at least
+	 four cores.
+	 A realized placement is also written as CSV and read back, which has to
+	 give the same doubles, and one realized from compressed curves has to
+	 fill the box of its root point.
+
+	 The operators of the standalone tools are checked as well. They are off
+	 the evaluation path, so their failures are reported but do not fail the
+	 run, and the quadratic ones are timed on small curves.
+
+	 usage: GSTfuzz [--seed S] [--cases N] [--size N]
+	                [--baseline FILE] [--write-baseline FILE] [--tolerance T] */
+
+using Curve = ShapeCurve<double>;
+
+/* Kernel under test: combine two child curves into the parent curve, both
+	 side by side and stacked */
+using Kernel = std::function<void(Curve const& left, Curve const& right, Curve& out)>;
+/* The same on leaves, each a staircase held by a hard leaf or a soft module */
+using SoftKernel = std::function<void(Subcircuit const& left, Subcircuit const& right, Curve& out)>;
+
+struct KernelEntry
+{
+	Kernel run;
+	/* Relative error the kernel may have on the front */
+	double tol;
+	/* Points per timed curve, 0 for the --size of the run */
+	int timingSize = 0;
+	/* Whether a failure fails the run */
+	bool gating = true;
+	/* Best-N pruning to this many points: the front may then be cut to its
+		 points of least area */
+	int keepBest = 0;
+	/* Set instead of run for kernels on leaves */
+	SoftKernel soft = {};
+};
+using Kernels = std::map<std::string, KernelEntry>;
+
+#pragma region Reference
+/* Pareto front of arbitrary points, sorted by width */
+Curve paretoFront(CurveView<double> c)
+{
+	std::vector<CurvePoint<double>> points(c.begin(), c.end());
+	std::sort(points.begin(), points.end(), [](CurvePoint<double> a, CurvePoint<double> b) {
+		return a.w != b.w ? a.w < b.w : a.h < b.h;
+	});
+	Curve front;
+	for (auto p : points)
+	{
+		if (!front.empty() && p.h >= front.h(front.size() - 1)) continue;
+		front.push_back(p.w, p.h);
+	}
+	return front;
+}
+
+/* Every pair side by side and stacked */
+void bruteCombine(Curve const& left, Curve const& right, Curve& out)
+{
+	Curve all;
+	for (size_t i = 0; i < left.size(); i++)
+	{
+		for (size_t j = 0; j < right.size(); j++)
+		{
+			all.push_back(left.w(i) + right.w(j), std::max(left.h(i), right.h(j)));
+			all.push_back(std::max(left.h(i), right.h(j)), left.w(i) + right.w(j));
+		}
+	}
+	out = paretoFront(all);
+}
+#pragma endregion
+
+#pragma region Kernels
+/* Two leaves holding the given curves and their parent */
+GST pairGST(Curve const& left, Curve const& right)
+{
+	GST gst;
+	gst.verbose = false;
+	for (auto const* c : {&left, &right})
+	{
+		Subcircuit leaf(0, true, true, 0, 0);
+		storeCurve(leaf, Curve(*c));
+		gst.createPi(leaf);
+		gst.leftChild.push_back(-1);
+		gst.rightChild.push_back(-1);
+	}
+	gst.nodes.emplace_back();
+	gst.leftChild.push_back(0);
+	gst.rightChild.push_back(1);
+	/* Such a fine grid only drops dominated points */
+	gst.prune = PruneMode::EpsilonGrid;
+	gst.pruneEpsilon = 1e-12;
+	return gst;
+}
+
+Kernel combineNodeKernel(PruneMode prune, WorkStealingPool* pool, size_t sliceMin, bool half = false, int pruneN = 0)
+{
+	return [=](Curve const& left, Curve const& right, Curve& out) {
+		GST gst = pairGST(left, right);
+		gst.prune = prune;
+		if (pruneN > 0) gst.pruneN = pruneN;
+		gst.pool = pool;
+		gst.parallelCombineMin = sliceMin;
+		gst.recordBackPointers = true;
+		gst.symmetricHalves = half;
+		combineNode(2, gst);
+		expandSymmetric(2, gst);
+		out = takeCurve(gst.nodes[2]);
+	};
+}
+
+/* Integer kernel on a grid that holds every coordinate of the random cases */
+void dbuKernel(Curve const& left, Curve const& right, Curve& out)
+{
+	DbuGrid grid(1.0 / 4);
+	GST gst = pairGST(left, right);
+	gst.recordBackPointers = true;
+	DbuCurve<int32_t> children[2], parent;
+	for (int side = 0; side < 2; side++)
+	{
+		auto const& c = side == 0 ? left : right;
+		for (auto p : c.view()) children[side].curve.push_back(grid.toDbu<int32_t>(p.w), grid.toDbu<int32_t>(p.h));
+	}
+	combineDbu(children[0], children[1], gst, parent);
+	out.clear();
+	for (auto p : parent.curve.view()) out.push_back(grid.toUser(p.w), grid.toUser(p.h));
+}
+
+/* Samples of an implicit leaf combined without a partner curve, few so
+	 that the error of the sampling shows. A parent combined in closed form
+	 is sampled finely, its aspect range is the wider one */
+constexpr int kSoftPoints = 32;
+constexpr int kClosedFormPoints = 1024;
+
+/* Lazy backend: soft leaves stay implicit and are combined in closed form,
+	 or sampled against their partner */
+SoftKernel lazyKernel(WorkStealingPool* pool, size_t sliceMin, bool half = false)
+{
+	return [=](Subcircuit const& left, Subcircuit const& right, Curve& out) {
+		GST gst = pairGST(Curve(), Curve());
+		gst.nodes[0] = left;
+		gst.nodes[1] = right;
+		for (int n = 0; n < 2; n++) gst.nodes[n].is_implicit = !gst.nodes[n].is_hard;
+		gst.lazySoftLeaves = true;
+		gst.softPoints = kSoftPoints;
+		gst.pool = pool;
+		gst.parallelCombineMin = sliceMin;
+		gst.recordBackPointers = true;
+		gst.symmetricHalves = half;
+		combineNode(2, gst);
+		materializeImplicit(2, gst, kClosedFormPoints);
+		expandSymmetric(2, gst);
+		out = takeCurve(gst.nodes[2]);
+	};
+}
+
+/* Side by side on compressed curves; the transposes go through flipCurve */
+void compressedKernel(Curve const& left, Curve const& right, Curve& out)
+{
+	double const quantum = 1.0 / 1024;
+	GST gst = pairGST(left, right);
+	combineCompressed(compressCurve(left, quantum), compressCurve(right, quantum),
+		gst.nodes[2].shapeCurveX, gst.nodes[2].shapeCurveY);
+	flipCurve(2, gst);
+	out = takeCurve(gst.nodes[2]);
+}
+#pragma endregion
+
+#pragma region Tools
+/* The tools are compiled in, each in its own namespace and with its main
+	 renamed, so the fuzzer checks their own operators. tree4.cpp, tree5.cpp
+	 and unit_test.cpp share PointsCurve.hpp; tree6.cpp and tree7.cpp are
+	 unfinished and do not compile */
+#define main toolMain
+namespace tree0
+{
+#include "tree.cpp"
+}
+namespace tree1
+{
+#include "tree1.cpp"
+}
+namespace tree2
+{
+#include "tree2.cpp"
+}
+namespace tree3
+{
+#include "tree3.cpp"
+}
+#undef main
+
+/* Side by side, transpose and merge of a tree*.cpp tool. Their curves are
+	 containers of points with width and height members */
+template<typename ToolCurve, typename MakePoint, typename Add, typename Flip, typename Merge>
+Kernel toolKernel(MakePoint makePoint, Add add, Flip flip, Merge merge)
+{
+	return [=](Curve const& left, Curve const& right, Curve& out) {
+		auto toTool = [&](Curve const& c) {
+			ToolCurve t;
+			for (auto p : c.view()) t.insert(t.end(), makePoint(p.w, p.h));
+			return t;
+		};
+		ToolCurve ch = add(toTool(left), toTool(right));
+		ToolCurve merged = merge(ch, flip(ch));
+		out.clear();
+		for (auto const& p : merged) out.push_back(p.width, p.height);
+	};
+}
+
+/* The PointsCurve.hpp operators */
+void pointsKernel(Curve const& left, Curve const& right, Curve& out)
+{
+	auto toPoints = [](Curve const& c) {
+		Points points;
+		for (auto p : c.view()) points.push_back({p.w, p.h});
+		return points;
+	};
+	Points ch = addition(toPoints(left), toPoints(right));
+	Points merged = merging(ch, flipping(ch));
+	out.clear();
+	for (auto const& p : merged) out.push_back(p.first, p.second);
+}
+#pragma endregion
+
+#pragma region Fuzzing
+/* Random staircase. Values sit on a coarse grid so that equal heights and
+	 widths, the cases where sweeps usually go wrong, are common */
+Curve randomStaircase(std::mt19937_64& rng, int maxSize)
+{
+	std::uniform_int_distribution<int> sizeDist(1, maxSize);
+	std::uniform_int_distribution<int> stepDist(0, 3);
+	int size = sizeDist(rng);
+	Curve c;
+	double w = 1 + stepDist(rng) / 4.0, h = 64 + stepDist(rng);
+	for (int i = 0; i < size; i++)
+	{
+		c.push_back(w, h);
+		w += (1 + stepDist(rng)) / 4.0;
+		h = std::max(0.25, h - (1 + stepDist(rng)) / 4.0);
+		if (h == c.h(i)) break;
+	}
+	return c;
+}
+
+using Buildable = std::function<bool(CurvePoint<double>)>;
+
+/* Compare fronts. Returns an empty string if they agree within tol, which
+	 absorbs the rounding of quantized kernels. A kernel with keepBest set
+	 may cut the front to the points of least area, at least one, and has to
+	 keep every optimal shape of less area than one it keeps. Kernel points
+	 must be buildable, which by default means covered by want */
+std::string compareFronts(Curve const& got, Curve const& want, double tol, int keepBest = 0, Buildable buildable = {})
+{
+	Curve front = paretoFront(got);
+	std::ostringstream why;
+	auto covered = [&](Curve const& by, CurvePoint<double> p, double slack) {
+		for (auto q : by.view())
+		{
+			if (q.w <= p.w * (1 + slack) && q.h <= p.h * (1 + slack)) return true;
+		}
+		return false;
+	};
+	if (!buildable) buildable = [&](CurvePoint<double> p) { return covered(want, p, 1e-12); };
+	for (auto p : front.view())
+	{
+		if (!buildable(p))
+		{
+			why<<"point ("<<p.w<<", "<<p.h<<") is better than any real shape";
+			return why.str();
+		}
+	}
+	double kept = INFINITY;
+	if (keepBest > 0)
+	{
+		if (front.size() == 0 && want.size() > 0) return "every shape was pruned";
+		kept = 0;
+		for (auto p : front.view()) kept = std::max(kept, p.w * p.h);
+	}
+	for (auto p : want.view())
+	{
+		if (p.w * p.h > kept * (1 + 1e-12)) continue;
+		if (!covered(front, p, tol))
+		{
+			why<<"optimal shape ("<<p.w<<", "<<p.h<<") is missing";
+			return why.str();
+		}
+	}
+	return "";
+}
+
+/* Least width of a leaf at most h high: of a staircase its narrowest point
+	 that low, of a soft module its hyperbola within the aspect bounds */
+double leastWidth(Subcircuit const& leaf, double h)
+{
+	double w = INFINITY;
+	if (leaf.is_hard)
+	{
+		for (auto p : curveView(leaf)) if (p.h <= h) w = std::min(w, p.w);
+		return w;
+	}
+	double lo, hi;
+	softHeightRange(leaf, lo, hi);
+	return h < lo ? w : leaf.area / std::min(h, hi);
+}
+
+/* Whether the leaves fit a w x h box side by side, or both turned and
+	 stacked */
+bool fitsBox(Subcircuit const& left, Subcircuit const& right, CurvePoint<double> p)
+{
+	double const slack = 1 + 1e-12;
+	auto sideBySide = [&](double w, double h) { return leastWidth(left, h * slack) + leastWidth(right, h * slack) <= w * slack; };
+	return sideBySide(p.w, p.h) || sideBySide(p.h, p.w);
+}
+
+std::string describe(Curve const& c)
+{
+	std::ostringstream os;
+	for (auto p : c.view()) os<<" ("<<p.w<<", "<<p.h<<")";
+	return os.str();
+}
+
+/* Soft module with heights in the range of the random staircases */
+Subcircuit randomSoftLeaf(std::mt19937_64& rng)
+{
+	std::uniform_real_distribution<double> area(16, 2048), low(0.25, 1), high(1, 4);
+	return Subcircuit(area(rng), false, true, low(rng), high(rng));
+}
+
+Subcircuit staircaseLeaf(Curve const& c)
+{
+	Subcircuit leaf(0, true, true, 0, 0);
+	storeCurve(leaf, Curve(c));
+	return leaf;
+}
+
+/* Fine samples of a soft module, which are all real shapes, or the curve of
+	 a staircase leaf */
+Curve referenceCurve(Subcircuit const& leaf)
+{
+	if (leaf.is_hard) return Curve(curveView(leaf));
+	Subcircuit sampled = leaf;
+	sampleSoftCurve(leaf, sampled.shapeCurveX, sampled.shapeCurveY, 256);
+	return takeCurve(sampled);
+}
+
+/* Run every kernel on cases random pairs, the soft kernels on every eighth
+	 as many pairs of leaves: two soft modules, or one beside a staircase.
+	 Returns the number of failures and prints the first failing case of each
+	 kernel */
+int fuzz(Kernels const& kernels, uint64_t seed, int cases)
+{
+	std::mt19937_64 rng(seed);
+	std::map<std::string, int> failures;
+	std::map<std::string, int> runs;
+	for (int k = 0; k < cases; k++)
+	{
+		Curve left = randomStaircase(rng, 1 + k % 40);
+		Curve right = randomStaircase(rng, 1 + (k * 7) % 40);
+		Curve want;
+		bruteCombine(left, right, want);
+		for (auto const& [name, kernel] : kernels)
+		{
+			if (!kernel.run) continue;
+			Curve got;
+			kernel.run(left, right, got);
+			runs[name]++;
+			std::string why = compareFronts(got, want, kernel.tol, kernel.keepBest);
+			if (why.empty()) continue;
+			if (failures[name]++ == 0)
+			{
+				std::cout<<name<<" FAILED on case "<<k<<": "<<why<<"\n  left:"<<describe(left)<<"\n  right:"<<describe(right)<<"\n";
+			}
+		}
+	}
+	for (int k = 0; k < cases / 8; k++)
+	{
+		Subcircuit left = k % 3 == 1 ? staircaseLeaf(randomStaircase(rng, 1 + k % 40)) : randomSoftLeaf(rng);
+		Subcircuit right = k % 3 == 2 ? staircaseLeaf(randomStaircase(rng, 1 + (k * 7) % 40)) : randomSoftLeaf(rng);
+		Curve want;
+		bruteCombine(referenceCurve(left), referenceCurve(right), want);
+		auto describeLeaf = [](Subcircuit const& leaf) {
+			if (leaf.is_hard) return describe(Curve(curveView(leaf)));
+			std::ostringstream os;
+			os<<" soft, area "<<leaf.area<<", aspect "<<leaf.par1<<" to "<<leaf.par2;
+			return os.str();
+		};
+		for (auto const& [name, kernel] : kernels)
+		{
+			if (!kernel.soft) continue;
+			Curve got;
+			kernel.soft(left, right, got);
+			runs[name]++;
+			std::string why = compareFronts(got, want, kernel.tol, 0, [&](CurvePoint<double> p) { return fitsBox(left, right, p); });
+			if (why.empty()) continue;
+			if (failures[name]++ == 0)
+			{
+				std::cout<<name<<" FAILED on case "<<k<<": "<<why<<"\n  left:"<<describeLeaf(left)<<"\n  right:"<<describeLeaf(right)<<"\n";
+			}
+		}
+	}
+	int total = 0;
+	for (auto const& [name, kernel] : kernels)
+	{
+		std::cout<<std::left<<std::setw(24)<<name<<(failures[name] ? "FAIL " : "ok   ")<<failures[name]<<" / "<<runs[name]
+			<<(kernel.gating ? "" : "  (tool, not gating)")<<"\n";
+		if (kernel.gating) total += failures[name];
+	}
+	return total;
+}
+#pragma endregion
+
+#pragma region Round trips
+/* Realize the root point of least area of a generated tree, write it as CSV
+	 and read it back. Returns an empty string if every value comes back
+	 exactly */
+int leastAreaPoint(Subcircuit const& node)
+{
+	int best = 0;
+	for (size_t i = 1; i < node.shapeCurveX.size(); i++)
+	{
+		if (node.shapeCurveX[i] * node.shapeCurveY[i] < node.shapeCurveX[best] * node.shapeCurveY[best]) best = i;
+	}
+	return best;
+}
+
+std::string placementRoundTrip(uint64_t seed)
+{
+	GeneratorConfig cfg;
+	cfg.numLeaves = 200;
+	cfg.seed = seed;
+	GST gst = generateGST(cfg);
+	gst.recordBackPointers = true;
+	evaluateGST(gst, 50);
+	Node root = gst.nodes.size() - 1;
+	auto rects = realizePlacement(gst, root, leastAreaPoint(gst.nodes[root]));
+
+	std::stringstream csv;
+	writePlacementCSV(csv, rects);
+	std::string line;
+	std::getline(csv, line);
+	for (size_t i = 0; i < rects.size(); i++)
+	{
+		std::getline(csv, line);
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::istringstream fields(line);
+		size_t leaf;
+		LeafRect r;
+		fields>>leaf>>r.x>>r.y>>r.w>>r.h;
+		auto const& want = rects[i];
+		if (!fields || leaf != i || r.x != want.x || r.y != want.y || r.w != want.w || r.h != want.h)
+		{
+			return "leaf " + std::to_string(i) + " reads back as \"" + line + "\"";
+		}
+	}
+	return "";
+}
+
+/* Same tree evaluated on a coarse compression grid: once decoded, the
+	 placement of the root point of least area has to fill exactly that
+	 point's box */
+std::string compressedPlacement(uint64_t seed)
+{
+	GeneratorConfig cfg;
+	cfg.numLeaves = 200;
+	cfg.seed = seed;
+	GST gst = generateGST(cfg);
+	gst.recordBackPointers = true;
+	auto compressed = evaluateCompressed(gst, 0.25, 50);
+	decompressCurves(gst, compressed);
+	Node root = gst.nodes.size() - 1;
+	int best = leastAreaPoint(gst.nodes[root]);
+	double w = 0, h = 0;
+	for (auto const& r : realizePlacement(gst, root, best))
+	{
+		w = std::max(w, r.x + r.w);
+		h = std::max(h, r.y + r.h);
+	}
+	double wantW = gst.nodes[root].shapeCurveX[best], wantH = gst.nodes[root].shapeCurveY[best];
+	if (std::abs(w - wantW) > 1e-9 * wantW || std::abs(h - wantH) > 1e-9 * wantH)
+	{
+		std::ostringstream why;
+		why<<std::setprecision(17)<<"placement is "<<w<<" x "<<h<<", root point "<<wantW<<" x "<<wantH;
+		return why.str();
+	}
+	return "";
+}
+#pragma endregion
+
+#pragma region Timing
+/* Smooth staircase of size points, like a sampled soft module */
+Curve hyperbola(double area, int size)
+{
+	Curve c;
+	for (int i = 0; i < size; i++)
+	{
+		double w = std::sqrt(area) * (0.25 + 3.75 * i / size);
+		c.push_back(w, area / w);
+	}
+	return c;
+}
+
+/* Timings are compared as ratios to this kernel's, which cancels the speed
+	 of the machine */
+constexpr char const* kReferenceKernel = "combineNode";
+
+struct Timing
+{
+	/* Nanoseconds per input point */
+	double ns;
+	/* Relative to kReferenceKernel on the same curves */
+	double ratio;
+};
+
+/* Best of a few runs of every kernel, each run next to one of the reference
+	 kernel, so that both see the same state of the machine. Soft kernels
+	 combine a staircase with a soft module that the staircase samples at
+	 about as many heights */
+std::map<std::string, Timing> measure(Kernels const& kernels, int defaultSize)
+{
+	std::map<std::string, Timing> result;
+	auto const& reference = kernels.at(kReferenceKernel);
+	for (auto const& [name, kernel] : kernels)
+	{
+		int size = kernel.timingSize ? kernel.timingSize : defaultSize;
+		Curve left = hyperbola(10, size), right = hyperbola(7, size);
+		Subcircuit hardLeft = staircaseLeaf(left), softRight(7, false, true, 1.0 / 16, 16);
+		auto time = [&](KernelEntry const& k) {
+			Curve out;
+			auto start = std::chrono::steady_clock::now();
+			if (k.run) k.run(left, right, out);
+			else k.soft(hardLeft, softRight, out);
+			return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (2.0 * size);
+		};
+		double best = INFINITY, bestReference = INFINITY;
+		for (int run = 0; run < 5; run++)
+		{
+			best = std::min(best, time(kernel));
+			bestReference = std::min(bestReference, time(reference));
+		}
+		result[name] = {best, name == kReferenceKernel ? 1 : best / bestReference};
+	}
+	return result;
+}
+
+/* Baseline files hold one "kernel ratio" pair per line, the time per point
+	 relative to kReferenceKernel */
+std::map<std::string, double> readBaseline(std::string const& path)
+{
+	std::map<std::string, double> baseline;
+	std::ifstream is(path);
+	std::string name;
+	double value;
+	while (is>>name>>value) baseline[name] = value;
+	return baseline;
+}
+#pragma endregion
+
+int main(int argc, char** argv)
+{
+	uint64_t seed = 1;
+	int cases = 2000;
+	int size = 1 << 18;
+	double tolerance = 0.25;
+	std::string baselinePath = "GSTfuzz.baseline", writePath;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cerr<<"missing value for "<<arg<<"\n";
+			return 2;
+		}
+		std::string value = argv[++i];
+		try
+		{
+			if (arg == "--seed") seed = std::stoull(value);
+			else if (arg == "--cases") cases = std::stoi(value);
+			else if (arg == "--size") size = std::stoi(value);
+			else if (arg == "--tolerance") tolerance = std::stod(value);
+			else if (arg == "--baseline") baselinePath = value;
+			else if (arg == "--write-baseline") writePath = value;
+			else
+			{
+				std::cerr<<"unknown option "<<arg<<"\n";
+				return 2;
+			}
+		}
+		catch (std::exception const&)
+		{
+			std::cerr<<"bad value for "<<arg<<": "<<value<<"\n";
+			return 2;
+		}
+	}
+	if (cases < 0 || size < 1 || tolerance < 0)
+	{
+		std::cerr<<"cases, size and tolerance must be positive\n";
+		return 2;
+	}
+
+	WorkStealingPool pool(4);
+	/* pairGST leaves the delta at its default */
+	double const simplifyDelta = GST().pruneDelta;
+	int const toolSize = std::min(size, 1 << 10);
+	/* Small enough that the random fronts are pruned */
+	int const kBestN = 8;
+	/* An optimal shape lies between two samples of a soft module. The widths
+		 of a random one span at most a factor sqrt(4 / 0.25), so neighbouring
+		 samples are at most 3 / (kSoftPoints - 1) of its width apart */
+	double const kSoftTol = 3.0 / (kSoftPoints - 1) + 1e-12;
+	Kernels kernels{
+		{"combineNode", {combineNodeKernel(PruneMode::EpsilonGrid, nullptr, 0), 1e-12}},
+		{"combineNode/bestN", {combineNodeKernel(PruneMode::BestN, nullptr, 0, false, kBestN), 1e-12, 0, true, kBestN}},
+		{"combineNode/sliced", {combineNodeKernel(PruneMode::EpsilonGrid, &pool, 2), 1e-12}},
+		{"combineNode/half", {combineNodeKernel(PruneMode::EpsilonGrid, &pool, 2, true), 1e-12}},
+		{"combineNode/simplify", {combineNodeKernel(PruneMode::Simplify, nullptr, 0), std::sqrt(1 + simplifyDelta) - 1 + 1e-12}},
+		{"combineCompressed", {compressedKernel, 1.0 / 1024}},
+		{"combineDbu", {dbuKernel, 1e-12}},
+		{"lazy", {{}, kSoftTol, 0, true, 0, lazyKernel(nullptr, 0)}},
+		{"lazy/half", {{}, kSoftTol, 0, true, 0, lazyKernel(nullptr, 0, true)}},
+		{"lazy/sliced", {{}, kSoftTol, 0, true, 0, lazyKernel(&pool, 2)}},
+		{"tool/PointsCurve", {pointsKernel, 1e-12, 0, false}},
+		{"tool/tree", {toolKernel<tree0::ShapeCurve>([](double w, double h) { return tree0::ShapePoint(w, h, w * h); },
+			tree0::addCurvesHorizontally, tree0::flipCurveVertically, tree0::mergeCurves), 1e-12, toolSize, false}},
+		{"tool/tree1", {toolKernel<tree1::ShapeCurve>([](double w, double h) { return tree1::module(w, h, w * h); },
+			tree1::addCurvesHorizontally, tree1::flipCurveVertically, tree1::mergeCurves), 1e-12, toolSize, false}},
+		{"tool/tree2", {toolKernel<tree2::ShapeCurve>([](double w, double h) { return tree2::module(w, h, w * h); },
+			tree2::addCurvesHorizontally, tree2::flipCurveVertically, tree2::mergeCurves), 1e-12, toolSize, false}},
+		{"tool/tree3", {toolKernel<tree3::ShapeCurve>([](double w, double h) { return tree3::module(w, h); },
+			tree3::addCurvesHorizontally, tree3::flipCurveVertically, tree3::mergeCurves), 1e-12, toolSize, false}},
+	};
+
+	int failed = fuzz(kernels, seed, cases);
+	std::string why = placementRoundTrip(seed);
+	std::cout<<std::left<<std::setw(24)<<"placement CSV"<<(why.empty() ? "ok" : "FAIL " + why)<<"\n";
+	failed += !why.empty();
+	why = compressedPlacement(seed);
+	std::cout<<std::left<<std::setw(24)<<"compressed placement"<<(why.empty() ? "ok" : "FAIL " + why)<<"\n";
+	failed += !why.empty();
+
+	/* The sliced kernels are timed at their default slice size */
+	kernels["combineNode/sliced"].run = combineNodeKernel(PruneMode::EpsilonGrid, &pool, GST().parallelCombineMin);
+	kernels["combineNode/half"].run = combineNodeKernel(PruneMode::EpsilonGrid, &pool, GST().parallelCombineMin, true);
+	kernels["lazy/sliced"].soft = lazyKernel(&pool, GST().parallelCombineMin);
+	auto timing = measure(kernels, size);
+	auto baseline = baselinePath.empty() ? std::map<std::string, double>() : readBaseline(baselinePath);
+	if (!baselinePath.empty() && baseline.empty()) std::cout<<"\nno baseline in "<<baselinePath<<"\n";
+	int regressed = 0;
+	std::cout<<"\n"<<std::left<<std::setw(24)<<"kernel"<<std::right<<std::setw(12)<<"ns/point"<<std::setw(12)<<"ratio"
+		<<std::setw(12)<<"baseline"<<"\n";
+	for (auto const& [name, t] : timing)
+	{
+		std::cout<<std::left<<std::setw(24)<<name<<std::right<<std::fixed<<std::setprecision(2)<<std::setw(12)<<t.ns
+			<<std::setprecision(3)<<std::setw(12)<<t.ratio;
+		auto it = baseline.find(name);
+		if (it != baseline.end())
+		{
+			bool slower = t.ratio > it->second * (1 + tolerance);
+			regressed += slower && kernels.at(name).gating;
+			std::cout<<std::setw(12)<<it->second<<(slower ? "  REGRESSED" : "");
+		}
+		std::cout<<"\n";
+	}
+	if (!writePath.empty())
+	{
+		std::ofstream os(writePath);
+		for (auto const& [name, t] : timing) os<<name<<" "<<t.ratio<<"\n";
+		os.close();
+		if (!os)
+		{
+			std::cerr<<"cannot write "<<writePath<<"\n";
+			return 2;
+		}
+	}
+	return failed || regressed ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "GSTrevise.hpp"
+#include <random>
+
+#pragma region SyntheticGST
+/* Topology of the generated slicing tree.
+	 Balanced: every node splits its leaves in halves.
+	 Skewed: every node splits its leaves by GeneratorConfig::skew.
+	 Caterpillar: every internal node has one leaf child.
+	 Random: every node splits at a uniformly random position */
+enum class TreeShape
+{
+	Balanced,
+	Skewed,
+	Caterpillar,
+	Random
+};
+
+struct GeneratorConfig
+{
+	int numLeaves = 1000;
+	TreeShape shape = TreeShape::Balanced;
+	uint64_t seed = 1;
+
+	/* Fraction of the leaves that are hard modules */
+	double hardRatio = 0.2;
+	/* Share of the leaves going to the left child of a skewed node */
+	double skew = 0.9;
+
+	/* Leaf areas are log-uniform in [minArea, maxArea] */
+	double minArea = 1;
+	double maxArea = 100;
+	/* Soft leaves get aspect bounds [1/a, a] and hard leaves get aspect a or 1/a,
+		 with a log-uniform in [minAspect, maxAspect] */
+	double minAspect = 1;
+	double maxAspect = 4;
+};
+
+/* Build a GST with cfg.numLeaves leaves and numLeaves - 1 internal nodes in
+	 topological order, the root last. The same config always gives the same
+	 tree. Logging is turned off since the trees are meant to be large */
+inline GST generateGST(GeneratorConfig const& cfg)
+{
+	assert(cfg.numLeaves >= 2 && "A GST needs at least two leaves");
+	std::mt19937_64 rng(cfg.seed);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	auto logUniform = [&](double lo, double hi) {
+		return lo * std::pow(hi / lo, unit(rng));
+	};
+
+	GST gst;
+	gst.verbose = false;
+	gst.nodes.reserve(2 * cfg.numLeaves - 1);
+	gst.leftChild.reserve(2 * cfg.numLeaves - 1);
+	gst.rightChild.reserve(2 * cfg.numLeaves - 1);
+
+	for (int i = 0; i < cfg.numLeaves; i++)
+	{
+		double area = logUniform(cfg.minArea, cfg.maxArea);
+		double aspect = logUniform(cfg.minAspect, cfg.maxAspect);
+		if (unit(rng) < cfg.hardRatio)
+		{
+			if (unit(rng) < 0.5) aspect = 1 / aspect;
+			double w = std::sqrt(area / aspect);
+			gst.createPi({area, true, true, w, area / w});
+		}
+		else
+		{
+			gst.createPi({area, false, true, 1 / aspect, aspect});
+		}
+		gst.leftChild.push_back(-1);
+		gst.rightChild.push_back(-1);
+	}
+
+	auto split = [&](int lo, int hi) {
+		int size = hi - lo;
+		switch (cfg.shape)
+		{
+		case TreeShape::Balanced:
+			return lo + size / 2;
+		case TreeShape::Skewed:
+			return lo + std::clamp(int(size * cfg.skew), 1, size - 1);
+		case TreeShape::Caterpillar:
+			return lo + 1;
+		case TreeShape::Random:
+			return std::uniform_int_distribution<int>(lo + 1, hi - 1)(rng);
+		}
+		return lo + size / 2;
+	};
+
+	/* Split the leaf range [lo, hi) recursively and emit internal nodes in post
+		 order, so children always come before their parent. The recursion is
+		 kept on an explicit stack because caterpillars are as deep as they are
+		 wide */
+	struct Frame
+	{
+		int lo, hi, mid;
+		Node left = -1;
+	};
+	std::vector<Frame> stack{{0, cfg.numLeaves, split(0, cfg.numLeaves)}};
+	Node done = -1;
+	while (!stack.empty())
+	{
+		auto& f = stack.back();
+		if (done < 0)
+		{
+			/* Descend into the left range, or take it directly if it is a leaf */
+			if (f.left < 0)
+			{
+				if (f.mid - f.lo == 1) f.left = f.lo;
+				else
+				{
+					int lo = f.lo, hi = f.mid;
+					stack.push_back({lo, hi, split(lo, hi)});
+					continue;
+				}
+			}
+			if (f.hi - f.mid == 1) done = f.mid;
+			else
+			{
+				int lo = f.mid, hi = f.hi;
+				stack.push_back({lo, hi, split(lo, hi)});
+				continue;
+			}
+		}
+
+		/* A child is finished, attach it to the frame below */
+		if (f.left < 0)
+		{
+			f.left = done;
+			done = -1;
+			continue;
+		}
+		gst.nodes.emplace_back();
+		gst.leftChild.push_back(f.left);
+		gst.rightChild.push_back(done);
+		done = gst.nodes.size() - 1;
+		stack.pop_back();
+	}
+	return gst;
+}
+#pragma endregion
@@ -0,0 +1,302 @@
+#pragma once
+
+#include "GSTrevise.hpp"
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#pragma region GSTInput
+/* Text input of the GST tools. Blank lines and everything after a '#' are
+	 ignored. Every value has to be a finite number; nan and inf are rejected.
+	 Module list, one leaf per line: area hard par1 par2, where hard is 0 or 1
+	 and par1, par2 are the aspect bounds of a soft module or the width and
+	 height of a hard one, as in Subcircuit.
+	 Partition, one internal node per line: left right. Internal nodes are
+	 numbered after the leaves in file order, so a child must be a leaf or an
+	 earlier line. The last line is the root, and the nodes form one tree:
+	 every other node is the child of exactly one line.
+	 Curve, one point per line: w h */
+struct ParseError : std::runtime_error
+{
+	ParseError(std::string const& file, size_t line, std::string const& what) :
+		std::runtime_error(file + ":" + std::to_string(line) + ": " + what), line(line) {}
+
+	size_t line;
+};
+
+/* Read-only view of a whole file. Regular files are mapped, anything else,
+	 like a pipe, is read into memory */
+class MappedFile
+{
+public:
+	explicit MappedFile(std::string const& path)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::runtime_error("cannot open " + path);
+		struct stat st;
+		if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+		{
+			void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				::madvise(p, st.st_size, MADV_SEQUENTIAL);
+				data_ = static_cast<char const*>(p);
+				size_ = st.st_size;
+				mapped_ = true;
+			}
+		}
+		::close(fd);
+		if (!mapped_)
+		{
+			std::ifstream is(path, std::ios::binary);
+			if (!is) throw std::runtime_error("cannot open " + path);
+			std::ostringstream ss;
+			ss<<is.rdbuf();
+			buffer_ = ss.str();
+			data_ = buffer_.data();
+			size_ = buffer_.size();
+		}
+	}
+
+	~MappedFile()
+	{
+		if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+	}
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	char const* data() const { return data_; }
+	size_t size() const { return size_; }
+
+private:
+	char const* data_ = nullptr;
+	size_t size_ = 0;
+	bool mapped_ = false;
+	std::string buffer_;
+};
+
+namespace gst_io
+{
+	/* Least bytes per chunk when the parse is split across a pool */
+	constexpr size_t kChunkBytes = 1 << 20;
+
+	struct Chunk
+	{
+		std::vector<double> values;
+		size_t lines = 0;
+		/* First error, at a line counted from the start of the chunk */
+		size_t errorLine = 0;
+		std::string error;
+	};
+
+	inline char const* skipBlanks(char const* p, char const* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+		return p;
+	}
+
+	/* Parse the whole lines in [p, end) into rows of columns numbers. check
+		 gets each row and returns an error message or nullptr. Parsing stops
+		 at the first error */
+	template<typename Check>
+	void parseChunk(char const* p, char const* end, int columns, Check const& check, Chunk& out)
+	{
+		while (p < end && out.error.empty())
+		{
+			char const* lineEnd = static_cast<char const*>(std::memchr(p, '\n', end - p));
+			if (!lineEnd) lineEnd = end;
+			out.lines++;
+
+			char const* q = skipBlanks(p, lineEnd);
+			if (q < lineEnd && *q != '#')
+			{
+				size_t rowStart = out.values.size();
+				for (int c = 0; c < columns; c++)
+				{
+					q = skipBlanks(q, lineEnd);
+					if (q == lineEnd || *q == '#')
+					{
+						out.error = "expected " + std::to_string(columns) + " columns";
+						break;
+					}
+					double v;
+					auto res = std::from_chars(q, lineEnd, v);
+					if (res.ec != std::errc())
+					{
+						char const* word = std::find_if(q, lineEnd, [](char ch) { return ch == ' ' || ch == '\t' || ch == '\r'; });
+						out.error = "not a number: " + std::string(q, word);
+						break;
+					}
+					if (!std::isfinite(v))
+					{
+						out.error = "not a finite number: " + std::string(q, res.ptr);
+						break;
+					}
+					out.values.push_back(v);
+					q = res.ptr;
+				}
+				q = skipBlanks(q, lineEnd);
+				if (out.error.empty() && q < lineEnd && *q != '#') out.error = "expected " + std::to_string(columns) + " columns";
+				if (out.error.empty())
+				{
+					if (char const* msg = check(out.values.data() + rowStart)) out.error = msg;
+				}
+				if (!out.error.empty()) out.errorLine = out.lines;
+			}
+			p = lineEnd + 1;
+		}
+	}
+
+	/* Line of the given row of a file, for errors found after parsing */
+	inline size_t lineOfRow(std::string const& path, size_t row)
+	{
+		MappedFile file(path);
+		char const* p = file.data();
+		char const* end = p + file.size();
+		size_t line = 0;
+		while (p < end)
+		{
+			char const* lineEnd = static_cast<char const*>(std::memchr(p, '\n', end - p));
+			if (!lineEnd) lineEnd = end;
+			line++;
+			char const* q = skipBlanks(p, lineEnd);
+			if (q < lineEnd && *q != '#' && row-- == 0) break;
+			p = lineEnd + 1;
+		}
+		return line;
+	}
+
+	/* Parse a file of numeric columns into one row-major array. Large files
+		 are cut into chunks at line starts, which are parsed on the pool and
+		 concatenated; line numbers of errors are counted across the chunks, and
+		 the first error of the file is thrown */
+	template<typename Check>
+	std::vector<double> parseColumns(std::string const& path, int columns, Check const& check, WorkStealingPool* pool)
+	{
+		MappedFile file(path);
+		char const* begin = file.data();
+		char const* end = begin + file.size();
+
+		size_t count = 1;
+		if (pool) count = std::max<size_t>(1, std::min<size_t>(4 * pool->size(), file.size() / kChunkBytes));
+		std::vector<char const*> cut(count + 1, end);
+		cut[0] = begin;
+		for (size_t c = 1; c < count; c++)
+		{
+			char const* p = begin + file.size() * c / count;
+			p = std::max(p, cut[c - 1]);
+			char const* nl = static_cast<char const*>(std::memchr(p, '\n', end - p));
+			cut[c] = nl ? nl + 1 : end;
+		}
+
+		std::vector<Chunk> chunks(count);
+		auto parse = [&](size_t c) { parseChunk(cut[c], cut[c + 1], columns, check, chunks[c]); };
+		if (count > 1) pool->parallelFor(count, parse);
+		else parse(0);
+
+		size_t line = 0, total = 0;
+		for (auto const& chunk : chunks)
+		{
+			if (!chunk.error.empty()) throw ParseError(path, line + chunk.errorLine, chunk.error);
+			line += chunk.lines;
+			total += chunk.values.size();
+		}
+		if (count == 1) return std::move(chunks[0].values);
+		std::vector<double> values;
+		values.reserve(total);
+		for (auto const& chunk : chunks) values.insert(values.end(), chunk.values.begin(), chunk.values.end());
+		return values;
+	}
+}
+
+/* Append the modules of the file as leaves of gst */
+inline void readModules(std::string const& path, GST& gst, WorkStealingPool* pool = nullptr)
+{
+	auto rows = gst_io::parseColumns(path, 4, [](double const* r) -> char const* {
+		if (r[0] <= 0 || r[2] <= 0 || r[3] <= 0) return "area and bounds must be positive";
+		if (r[1] != 0 && r[1] != 1) return "hard must be 0 or 1";
+		if (r[1] == 0 && r[2] > r[3]) return "aspect bounds out of order";
+		return nullptr;
+	}, pool);
+
+	size_t count = rows.size() / 4;
+	gst.nodes.reserve(gst.nodes.size() + count);
+	gst.leftChild.resize(gst.leftChild.size() + count, -1);
+	gst.rightChild.resize(gst.rightChild.size() + count, -1);
+	for (size_t i = 0; i < count; i++)
+	{
+		double const* r = &rows[4 * i];
+		gst.createPi({r[0], r[1] == 1, true, r[2], r[3]});
+	}
+}
+
+/* Append the internal nodes of the file to gst, whose leaves are already
+	 read. Throws if a node gets a second parent or is left without one */
+inline void readPartition(std::string const& path, GST& gst, WorkStealingPool* pool = nullptr)
+{
+	auto rows = gst_io::parseColumns(path, 2, [](double const* r) -> char const* {
+		if (r[0] < 0 || r[1] < 0 || r[0] != std::floor(r[0]) || r[1] != std::floor(r[1])) return "children must be node indices";
+		if (r[0] == r[1]) return "children must be distinct";
+		return nullptr;
+	}, pool);
+
+	/* Children have to come first and have one parent, which depends on the
+		 lines before */
+	size_t first = gst.nodes.size();
+	std::vector<char> hasParent(first + rows.size() / 2, 0);
+	for (Node n = gst.numPi; n < Node(first); n++)
+	{
+		hasParent[gst.leftChild[n]] = 1;
+		hasParent[gst.rightChild[n]] = 1;
+	}
+	for (size_t i = 0; i < rows.size() / 2; i++)
+	{
+		if (rows[2 * i] >= first + i || rows[2 * i + 1] >= first + i)
+		{
+			throw ParseError(path, gst_io::lineOfRow(path, i), "children must be earlier nodes");
+		}
+		for (double child : {rows[2 * i], rows[2 * i + 1]})
+		{
+			if (hasParent[size_t(child)])
+			{
+				throw ParseError(path, gst_io::lineOfRow(path, i), "node " + std::to_string(size_t(child)) + " already has a parent");
+			}
+			hasParent[size_t(child)] = 1;
+		}
+		gst.nodes.emplace_back();
+		gst.leftChild.push_back(Node(rows[2 * i]));
+		gst.rightChild.push_back(Node(rows[2 * i + 1]));
+	}
+	for (size_t n = 0; n + 1 < hasParent.size(); n++)
+	{
+		if (!hasParent[n])
+		{
+			throw ParseError(path, gst_io::lineOfRow(path, rows.size() / 2 - 1), "node " + std::to_string(n) + " is not used, the partition must be one tree");
+		}
+	}
+}
+
+/* Write the internal nodes of gst in the format readPartition reads */
+inline void writePartition(std::ostream& os, GST const& gst)
+{
+	for (size_t n = gst.numPi; n < gst.nodes.size(); n++) os<<gst.leftChild[n]<<" "<<gst.rightChild[n]<<"\n";
+}
+
+/* Read a curve of "w h" lines. The parsed rows already are the interleaved
+	 points, so the curve takes them over as they are */
+inline ShapeCurve<double, CurveLayout::AoS> readCurve(std::string const& path, WorkStealingPool* pool = nullptr)
+{
+	auto rows = gst_io::parseColumns(path, 2, [](double const* r) -> char const* {
+		return r[0] > 0 && r[1] > 0 ? nullptr : "dimensions must be positive";
+	}, pool);
+	return ShapeCurve<double, CurveLayout::AoS>(std::move(rows));
+}
+#pragma endregion
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "GSTrevise.hpp"
+#include <fstream>
+#include <iomanip>
+
+#pragma region Placement
+/* Rectangle of a leaf in the realized floorplan, lower left corner at (x, y) */
+struct LeafRect
+{
+	double x = 0;
+	double y = 0;
+	double w = 0;
+	double h = 0;
+};
+
+/* Node of the top-down walk: the shape chosen for it and where it goes */
+struct PlaceItem
+{
+	Node n;
+	ShapeChoice c;
+	double x;
+	double y;
+};
+
+/* Place the whole subtree of item. Uses an explicit stack so skewed trees
+	 with millions of levels do not overflow the call stack */
+inline void placeSubtree(GST const& gst, PlaceItem item, std::vector<LeafRect>& rects)
+{
+	std::vector<PlaceItem> stack{item};
+	while (!stack.empty())
+	{
+		PlaceItem it = stack.back();
+		stack.pop_back();
+		if (it.n < gst.numPi)
+		{
+			rects[it.n] = {it.x, it.y, it.c.w, it.c.h};
+			continue;
+		}
+		ShapeChoice l, r;
+		bool horizontal = splitChoice(gst, it.n, it.c, l, r);
+		stack.push_back({gst.leftChild[it.n], l, it.x, it.y});
+		stack.push_back({gst.rightChild[it.n], r, horizontal ? it.x + l.w : it.x, horizontal ? it.y : it.y + l.h});
+	}
+}
+
+/* Spawn the left subtree as a task on the GST's pool while the top levels
+	 are walked, then fall back to the sequential walk. Every leaf owns its
+	 slot in rects, so tasks never write to the same place */
+inline void placeParallel(GST const& gst, PlaceItem item, std::vector<LeafRect>& rects, int depth)
+{
+	if (depth <= 0 || !gst.pool || item.n < gst.numPi)
+	{
+		placeSubtree(gst, item, rects);
+		return;
+	}
+	ShapeChoice l, r;
+	bool horizontal = splitChoice(gst, item.n, item.c, l, r);
+	PlaceItem left{gst.leftChild[item.n], l, item.x, item.y};
+	PlaceItem right{gst.rightChild[item.n], r, horizontal ? item.x + l.w : item.x, horizontal ? item.y : item.y + l.h};
+
+	auto task = gst.pool->spawn([&]() { placeParallel(gst, left, rects, depth - 1); });
+	placeParallel(gst, right, rects, depth - 1);
+	gst.pool->wait(task);
+}
+
+/* Realize the given point of the root curve as a floorplan with the root at
+	 the origin. Requires the curves to be combined with recordBackPointers.
+	 The result is indexed by leaf; leaves outside the root's subtree keep an
+	 empty rectangle. The top of the tree is split across the GST's pool */
+inline std::vector<LeafRect> realizePlacement(GST const& gst, Node root, int point)
+{
+	std::vector<LeafRect> rects(gst.numPi);
+	ShapeChoice c;
+	c.point = point;
+	c.used = true;
+	c.w = FullCurve(gst.nodes[root]).w(point);
+	c.h = FullCurve(gst.nodes[root]).h(point);
+
+	/* Two tasks per thread leave some room for unbalanced subtrees */
+	unsigned threads = gst.pool ? gst.pool->size() : 1;
+	int depth = 0;
+	while ((1u << depth) < 2 * threads) depth++;
+	placeParallel(gst, {root, c, 0, 0}, rects, threads > 1 ? depth : 0);
+	return rects;
+}
+
+/* CSV dump, one leaf per line, with the digits to read the doubles back
+	 exactly */
+inline void writePlacementCSV(std::ostream& os, std::vector<LeafRect> const& rects)
+{
+	os<<std::setprecision(17);
+	os<<"leaf,x,y,w,h\n";
+	for (size_t i = 0; i < rects.size(); i++)
+	{
+		auto const& r = rects[i];
+		os<<i<<","<<r.x<<","<<r.y<<","<<r.w<<","<<r.h<<"\n";
+	}
+}
+
+/* Binary dump: "GSTP", the leaf count as uint64, then x, y, w, h as doubles
+	 for every leaf in index order */
+inline void writePlacementBinary(std::ostream& os, std::vector<LeafRect> const& rects)
+{
+	uint64_t count = rects.size();
+	os.write("GSTP", 4);
+	os.write(reinterpret_cast<char const*>(&count), sizeof(count));
+	os.write(reinterpret_cast<char const*>(rects.data()), rects.size() * sizeof(LeafRect));
+}
+#pragma endregion
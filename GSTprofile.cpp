@@ -0,0 +1,25 @@
+/* Replacement global operator new/delete of the allocation profiler, see
+	 GSTprofile.hpp. Compiled once into a program built with
+	 -DGST_PROFILE_ALLOC, e.g.
+	 g++ -DGST_PROFILE_ALLOC GSTdriver.cpp GSTprofile.cpp */
+#include "GSTprofile.hpp"
+
+#ifdef GST_PROFILE_ALLOC
+
+namespace gst_profile
+{
+	struct Reporter
+	{
+		~Reporter() { printSummary(std::cout); }
+	};
+	Reporter reporter;
+}
+
+void* operator new(std::size_t size) { return gst_profile::allocate(size); }
+void* operator new[](std::size_t size) { return gst_profile::allocate(size); }
+void operator delete(void* ptr) noexcept { gst_profile::deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { gst_profile::deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { gst_profile::deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { gst_profile::deallocate(ptr); }
+
+#endif
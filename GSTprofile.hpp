@@ -0,0 +1,155 @@
+#pragma once
+
+/* Allocation profiler for the GST phases. Build with -DGST_PROFILE_ALLOC and
+	 add GSTprofile.cpp to the program, which replaces the global operator
+	 new/delete with counting versions; every allocation is then charged to
+	 the phase and tree level of the innermost GST_PROFILE_SCOPE on its
+	 thread, and a summary table is printed when the program exits. Without
+	 the define the scopes compile to nothing. The header can be included by
+	 any number of translation units, the operators live in GSTprofile.cpp */
+
+#include <iostream>
+
+enum class ProfilePhase
+{
+	Other,
+	LeafGeneration,
+	Combine,
+	Flip,
+	Prune,
+	Count
+};
+
+#ifdef GST_PROFILE_ALLOC
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#define GST_PROFILE_CONCAT_(a, b) a##b
+#define GST_PROFILE_CONCAT(a, b) GST_PROFILE_CONCAT_(a, b)
+#define GST_PROFILE_SCOPE(phase, level) ProfileScope GST_PROFILE_CONCAT(profileScope_, __LINE__)(phase, level)
+/* Same as GST_PROFILE_SCOPE, keeping the level of the enclosing scope */
+#define GST_PROFILE_PHASE(phase) GST_PROFILE_SCOPE(phase, gst_profile::current.level)
+
+namespace gst_profile
+{
+	/* Levels deeper than this are charged to the last one */
+	constexpr int kMaxLevel = 64;
+	constexpr int kPhases = static_cast<int>(ProfilePhase::Count);
+
+	struct Bucket
+	{
+		std::atomic<uint64_t> allocs{0};
+		std::atomic<uint64_t> bytes{0};
+		std::atomic<int64_t> live{0};
+		std::atomic<int64_t> peak{0};
+	};
+
+	inline Bucket buckets[kPhases][kMaxLevel + 1];
+	inline std::atomic<int64_t> totalLive{0};
+	inline std::atomic<int64_t> totalPeak{0};
+
+	struct Current
+	{
+		ProfilePhase phase = ProfilePhase::Other;
+		int level = 0;
+	};
+	inline thread_local Current current;
+
+	/* Every block carries its size and bucket in front of the user data. 16
+		 bytes keep the alignment that plain operator new guarantees */
+	struct alignas(16) Header
+	{
+		uint64_t size;
+		uint32_t bucket;
+	};
+	static_assert(sizeof(Header) == 16, "Allocation header must keep 16 byte alignment");
+
+	inline void raisePeak(std::atomic<int64_t>& peak, int64_t value)
+	{
+		int64_t old = peak.load(std::memory_order_relaxed);
+		while (value > old && !peak.compare_exchange_weak(old, value, std::memory_order_relaxed)) {}
+	}
+
+	inline void* allocate(std::size_t size)
+	{
+		auto* header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+		if (!header) throw std::bad_alloc();
+		int phase = static_cast<int>(current.phase);
+		int level = current.level < 0 ? 0 : (current.level > kMaxLevel ? kMaxLevel : current.level);
+		header->size = size;
+		header->bucket = phase * (kMaxLevel + 1) + level;
+
+		auto& b = buckets[phase][level];
+		b.allocs.fetch_add(1, std::memory_order_relaxed);
+		b.bytes.fetch_add(size, std::memory_order_relaxed);
+		raisePeak(b.peak, b.live.fetch_add(size, std::memory_order_relaxed) + size);
+		raisePeak(totalPeak, totalLive.fetch_add(size, std::memory_order_relaxed) + size);
+		return header + 1;
+	}
+
+	inline void deallocate(void* ptr)
+	{
+		if (!ptr) return;
+		auto* header = static_cast<Header*>(ptr) - 1;
+		auto& b = (&buckets[0][0])[header->bucket];
+		b.live.fetch_sub(header->size, std::memory_order_relaxed);
+		totalLive.fetch_sub(header->size, std::memory_order_relaxed);
+		std::free(header);
+	}
+
+	inline char const* phaseName(int phase)
+	{
+		static char const* names[] = {"other", "leaf", "combine", "flip", "prune"};
+		return names[phase];
+	}
+
+	/* Print one line per phase and level that allocated anything */
+	inline void printSummary(std::ostream& os)
+	{
+		os<<"\nAllocation profile\n";
+		os<<std::left<<std::setw(10)<<"phase"<<std::right<<std::setw(7)<<"level"<<std::setw(14)<<"allocs"
+			<<std::setw(16)<<"bytes"<<std::setw(16)<<"peak live"<<"\n";
+		for (int p = 0; p < kPhases; p++)
+		{
+			uint64_t allocs = 0, bytes = 0;
+			for (int l = 0; l <= kMaxLevel; l++)
+			{
+				auto const& b = buckets[p][l];
+				if (b.allocs == 0) continue;
+				allocs += b.allocs;
+				bytes += b.bytes;
+				os<<std::left<<std::setw(10)<<phaseName(p)<<std::right<<std::setw(7)<<l<<std::setw(14)<<b.allocs
+					<<std::setw(16)<<b.bytes<<std::setw(16)<<b.peak<<"\n";
+			}
+			if (allocs)
+			{
+				os<<std::left<<std::setw(10)<<phaseName(p)<<std::right<<std::setw(7)<<"all"<<std::setw(14)<<allocs
+					<<std::setw(16)<<bytes<<std::setw(16)<<"-"<<"\n";
+			}
+		}
+		os<<"peak live bytes overall: "<<totalPeak<<"\n";
+	}
+}
+
+/* Charge the allocations of the enclosing scope to phase and level */
+struct ProfileScope
+{
+	ProfileScope(ProfilePhase phase, int level) : saved(gst_profile::current)
+	{
+		gst_profile::current = {phase, level};
+	}
+	~ProfileScope() { gst_profile::current = saved; }
+
+	gst_profile::Current saved;
+};
+
+#else
+
+#define GST_PROFILE_SCOPE(phase, level) ((void)0)
+#define GST_PROFILE_PHASE(phase) ((void)0)
+
+#endif
@@ -0,0 +1,1362 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <set>
+#include <functional>
+#include <assert.h>
+#include <cmath>
+#include <memory> // for std::unique_ptr
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "GSTprofile.hpp"
+#include "WorkStealingPool.hpp"
+#include "ShapeCurve.hpp"
+
+using VecCurve = std::vector<double>;
+using Node = int;
+
+#pragma region SlicingTreeDef
+/* Back-pointer of a combined point. left and right are the indices of the
+	 child points that produced it; the top bit of left marks points that come
+	 from the flipped (vertically stacked) half of the curve */
+struct BackPointer
+{
+	static constexpr uint32_t kVertical = 0x80000000u;
+
+	BackPointer() = default;
+	BackPointer(uint32_t left, uint32_t right, bool vertical = false) :
+		left(vertical ? (left | kVertical) : left), right(right) {}
+
+	uint32_t leftIdx() const { return left & ~kVertical; }
+	uint32_t rightIdx() const { return right; }
+	bool isVertical() const { return (left & kVertical) != 0; }
+
+	uint32_t left = 0;
+	uint32_t right = 0;
+};
+
+/* The subcir is with two  parameters. The first indicates min aspect ratio
+	 of soft subcir or width of hard subcir. The second indicates max aspect 
+	 of soft subcir or height of hard subcir */
+struct Subcircuit
+{
+	Subcircuit() = default;
+	Subcircuit(double const& area, bool is_hard, bool is_leaf, double const& par1, double const& par2) : 
+		area(area), is_hard(is_hard), is_leaf(is_leaf), par1(par1), par2(par2) {}
+
+	
+	double area = -1;
+	bool is_hard = false;
+	bool is_leaf = false;
+	double par1 = -1;
+	double par2 = -1;
+	/* Height of the node in the tree, 0 for leaves */
+	int level = 0;
+	/* Curve is kept as y = area / x within the aspect bounds and only sampled
+		 when the parent is combined. Soft leaves, and internal nodes combined in
+		 closed form from two implicit children */
+	bool is_implicit = false;
+	/* Curve is symmetric about W = H and only its points with w <= h are
+		 stored, see FullCurve */
+	bool is_symmetric = false;
+
+	VecCurve shapeCurveX;
+	VecCurve shapeCurveY;
+
+	/* One entry per curve point, only filled by combineNode when the GST
+		 records back-pointers. Leaves never have one */
+	std::vector<BackPointer> backPtr;
+};
+
+/* Curve of a node as a view, and moved in and out of a node without copying.
+	 For a symmetric node these are the stored points only */
+inline CurveView<double> curveView(Subcircuit const& node)
+{
+	return curveView(node.shapeCurveX, node.shapeCurveY);
+}
+
+inline ShapeCurve<double> takeCurve(Subcircuit& node)
+{
+	return {std::move(node.shapeCurveX), std::move(node.shapeCurveY)};
+}
+
+inline void storeCurve(Subcircuit& node, ShapeCurve<double>&& curve)
+{
+	curve.release(node.shapeCurveX, node.shapeCurveY);
+}
+
+/* Curve of a node indexed as its full curve. Of a symmetric node only the
+	 first points up to the diagonal are stored; the rest are their mirror
+	 images in reverse order and are produced on the fly, with back-pointers
+	 that switch orientation. A point on the diagonal is its own mirror and
+	 appears once */
+struct FullCurve
+{
+	FullCurve(VecCurve const& X, VecCurve const& Y, bool half = false, std::vector<BackPointer> const* backPtr = nullptr) :
+		X(X.data()), Y(Y.data()), bp(backPtr && !backPtr->empty() ? backPtr->data() : nullptr), stored(X.size())
+	{
+		full = half && stored > 0 ? 2 * stored - (X[stored - 1] == Y[stored - 1]) : stored;
+	}
+	explicit FullCurve(Subcircuit const& node) :
+		FullCurve(node.shapeCurveX, node.shapeCurveY, node.is_symmetric, &node.backPtr) {}
+
+	size_t size() const { return full; }
+	double w(size_t k) const { return k < stored ? X[k] : Y[full - 1 - k]; }
+	double h(size_t k) const { return k < stored ? Y[k] : X[full - 1 - k]; }
+	BackPointer backPtr(size_t k) const
+	{
+		if (k < stored) return bp[k];
+		auto const& m = bp[full - 1 - k];
+		return BackPointer(m.leftIdx(), m.rightIdx(), !m.isVertical());
+	}
+
+	double const* X;
+	double const* Y;
+	BackPointer const* bp;
+	size_t stored;
+	size_t full;
+};
+
+/* Box of the shapes a node may take under a fixed outline. The upper bounds
+	 come top-down from the outline: a shape beyond them cannot be part of a
+	 root shape that fits. The lower bounds come bottom-up from the leaves: no
+	 shape of the subtree is narrower or lower */
+struct ShapeCurveRange
+{
+	ShapeCurveRange() = default;
+	ShapeCurveRange(double WMin, double WMax, double HMin, double HMax) :
+		W_min(WMin), W_max(WMax), H_min(HMin), H_max(HMax) {}
+
+	/* Whether a shape is within the upper bounds, or with turned, within them
+		 either as it is or turned by 90 degrees */
+	bool fits(double w, double h, bool turned = false) const
+	{
+		return (w <= W_max && h <= H_max) || (turned && h <= W_max && w <= H_max);
+	}
+
+	ShapeCurveRange scaled(double f) const { return {W_min * f, W_max * f, H_min * f, H_max * f}; }
+
+	double W_min = 0;
+	double W_max = INFINITY;
+	double H_min = 0;
+	double H_max = INFINITY;
+};
+
+/* How flipCurve bounds the size of a combined curve.
+	 BestN: keep the pruneN points with the smallest area.
+	 EpsilonGrid: drop dominated points and keep one point per cell of a
+	 logarithmic (W, H) grid with ratio 1 + pruneEpsilon.
+	 Simplify: drop dominated points and the fewest further points such that
+	 every shape of the curve loses at most a factor 1 + pruneDelta in area */
+enum class PruneMode
+{
+	BestN,
+	EpsilonGrid,
+	Simplify
+};
+
+/* In the GST, nodes starts with PI which is smallest subcircuit, then follows
+	 internal nodes. Commonly the last node is the root */
+struct GST
+{
+	std::vector<Subcircuit> nodes;
+
+	/* These two vector contains the index of nodes' left and right child. The index
+		 of each element indicates index of its parent */
+	std::vector<Node> leftChild;
+	std::vector<Node> rightChild;
+
+	void createPi(Subcircuit module)
+	{
+		nodes.push_back(module);
+		numPi++;
+	}
+
+	int numPi = 0;
+
+	/* Keep, for every combined point, the child points it was built from so a
+		 chosen root shape can be traced top-down without recomputing curves */
+	bool recordBackPointers = false;
+
+	/* Log every generated and combined node */
+	bool verbose = true;
+
+	/* Leave soft leaves implicit instead of sampling them in generatePoints */
+	bool lazySoftLeaves = false;
+	/* Samples per soft leaf when an implicit one is sampled for a combine,
+		 set by evaluateGST from its num_points */
+	int softPoints = 1000;
+
+	PruneMode prune = PruneMode::BestN;
+	int pruneN = 1000;
+	double pruneEpsilon = 0.01;
+	double pruneDelta = 0.01;
+
+	/* Pool used by evaluateGST and by the sliced combine of large curves. Not
+		 owned; nullptr runs everything on the calling thread */
+	WorkStealingPool* pool = nullptr;
+	/* Least number of merge steps per slice when a combine is split */
+	size_t parallelCombineMin = 1 << 15;
+
+	/* Store combined curves, which are symmetric after the flip, as their
+		 w <= h half */
+	bool symmetricHalves = false;
+
+	/* Whitespace budget of the branch-and-bound pruning, relative to the
+		 total leaf area. Combined points that cannot be part of a root shape
+		 within the budget are dropped. Negative turns it off */
+	double whitespace = -1;
+	/* Largest useful area per node, set by evaluateGST from the budget */
+	std::vector<double> areaLimit;
+
+	/* Chip outline of the fixed-outline mode. Root shapes have to fit it as
+		 they are, and shapes of a subtree that cannot be part of such a root
+		 are never generated. Zero turns it off */
+	double outlineW = 0;
+	double outlineH = 0;
+	/* Feasible shapes per node, set by evaluateGST from the outline */
+	std::vector<ShapeCurveRange> shapeRange;
+};
+#pragma endregion
+
+#pragma region SlicingTreeOper
+/* function to initialize GST */
+inline void initializeGST()
+{
+	/* Initialize the GST according to the result of partitioning. 
+		 1. Sort the nodes in topological order.
+		 2. Build the relationship of nodes and their chilren, child with larger
+		 aspect scope is regarded as left. */
+}
+
+/* Sample num_points points on y = area / x inside the aspect bounds, and
+	 inside the range if one is given. A range that leaves no width gives no
+	 points */
+inline void sampleSoftCurve(Subcircuit const& node, VecCurve& X, VecCurve& Y, int num_points, ShapeCurveRange const* range = nullptr)
+{
+	// Calculate the range for x based on the aspect ratio constraints
+	double x_min = std::sqrt(node.area / node.par2);
+	double x_max = std::sqrt(node.area/ node.par1);
+	if (range)
+	{
+		x_min = std::max(x_min, node.area / range->H_max);
+		x_max = std::min(x_max, range->W_max);
+		if (x_min > x_max) return;
+		if (x_min == x_max) num_points = 1;
+	}
+
+	double step = num_points > 1 ? (x_max - x_min) / (num_points - 1) : 0;
+
+	for (int i = 0; i < num_points; ++i) {
+		double x = x_min + i * step; 
+		double y = node.area / x;         
+		X.push_back(x);
+		Y.push_back(y);
+	}
+}
+
+/* Height range of a soft curve, from its aspect bounds */
+inline void softHeightRange(Subcircuit const& node, double& h_min, double& h_max)
+{
+	h_min = std::sqrt(node.area * node.par1);
+	h_max = std::sqrt(node.area * node.par2);
+}
+
+/* Sample an implicit soft leaf for a combine with a partner curve. The
+	 partner's heights inside the leaf's height range, and the two ends of the
+	 range, are where the combined curve has a corner: the partner steps there
+	 and the leaf matches its height exactly. Between them the combined curve
+	 follows the leaf's hyperbola, so the gaps are filled with samples no
+	 further apart in width than sampleSoftCurve would put num_points of them.
+	 Without a partner the leaf is sampled uniformly. A range narrows the
+	 height range first */
+inline void sampleImplicitLeaf(Subcircuit const& leaf, FullCurve const* partner, VecCurve& X, VecCurve& Y, int num_points = 1000,
+	ShapeCurveRange const* range = nullptr)
+{
+	if (!partner)
+	{
+		sampleSoftCurve(leaf, X, Y, num_points, range);
+		return;
+	}
+	double h_min, h_max;
+	softHeightRange(leaf, h_min, h_max);
+	if (range)
+	{
+		h_min = std::max(h_min, leaf.area / range->W_max);
+		h_max = std::min(h_max, range->H_max);
+		if (h_min > h_max) return;
+	}
+
+	VecCurve heights{h_max, h_min};
+	for (size_t k = 0; k < partner->size(); k++)
+	{
+		double h = partner->h(k);
+		if (h < h_max && h > h_min) heights.push_back(h);
+	}
+	std::sort(heights.begin(), heights.end(), std::greater<double>());
+	heights.erase(std::unique(heights.begin(), heights.end()), heights.end());
+
+	double step = num_points > 1 ? (leaf.area / h_min - leaf.area / h_max) / (num_points - 1) : INFINITY;
+	X.reserve(heights.size() + num_points);
+	Y.reserve(heights.size() + num_points);
+	for (size_t i = 0; i < heights.size(); i++)
+	{
+		double x = leaf.area / heights[i];
+		if (i > 0 && x - X.back() > step)
+		{
+			double from = X.back();
+			int gaps = std::ceil((x - from) / step);
+			for (int j = 1; j < gaps; j++)
+			{
+				X.push_back(from + j * (x - from) / gaps);
+				Y.push_back(leaf.area / X.back());
+			}
+		}
+		X.push_back(x);
+		Y.push_back(heights[i]);
+	}
+}
+
+/* Function to generate points on y = area / x */ 
+inline void generatePoints(Node n, GST& gst, int num_points = 1000) {
+	if (gst.verbose) std::cout<<"Generating Curve for node "<<n<<"\n";
+	GST_PROFILE_SCOPE(ProfilePhase::LeafGeneration, 0);
+	auto& node = gst.nodes[n];
+	ShapeCurveRange const* range = gst.shapeRange.empty() ? nullptr : &gst.shapeRange[n];
+
+	/* A hard subcir only has its two orientations */
+	if (node.is_hard)
+	{
+		double w = std::min(node.par1, node.par2);
+		double h = std::max(node.par1, node.par2);
+		if (!range || range->fits(w, h))
+		{
+			node.shapeCurveX.push_back(w);
+			node.shapeCurveY.push_back(h);
+		}
+		if (w != h && (!range || range->fits(h, w)))
+		{
+			node.shapeCurveX.push_back(h);
+			node.shapeCurveY.push_back(w);
+		}
+		return;
+	}
+
+	if (gst.lazySoftLeaves)
+	{
+		node.is_implicit = true;
+		return;
+	}
+	sampleSoftCurve(node, node.shapeCurveX, node.shapeCurveY, num_points, range);
+}
+
+/* Type that holds the area of a point with Coord dimensions exactly. Areas
+	 of int64 coordinates would not fit any integer, they fall back to double */
+template<typename Coord>
+using AreaOf = std::conditional_t<std::is_integral_v<Coord> && sizeof(Coord) <= 4, int64_t, double>;
+
+/* Select the best num nodes with less area. The back-pointers, if given, are
+	 filtered along with the points. The pruning functions work on double
+	 curves and on the integer ones of the database unit mode alike */
+template<typename Coord>
+void getBestN(std::vector<Coord>& vecW, std::vector<Coord>& vecH, int num, std::vector<BackPointer>* backPtr = nullptr)
+{
+	if (vecW.size() <= size_t(num)) return;
+	GST_PROFILE_PHASE(ProfilePhase::Prune);
+
+	using Area = AreaOf<Coord>;
+	std::vector<Area> vecArea;
+	int y = 0;
+	for (auto& w : vecW)
+	{
+		Area area = Area(w) * vecH[y];
+		vecArea.push_back(area);
+		y++;
+	}
+
+	std::vector<Area> temp = vecArea;
+	std::nth_element(temp.begin(), temp.begin() + num, temp.end());
+	Area nthValue = temp[num];
+
+	std::vector<Coord> BestW;
+	std::vector<Coord> BestH;
+	std::vector<BackPointer> BestPtr;
+	int idx = 0;
+	for (auto const& area : vecArea)
+	{
+		if (area <= nthValue)
+		{
+			BestW.push_back(vecW[idx]);
+			BestH.push_back(vecH[idx]);
+			if (backPtr) BestPtr.push_back((*backPtr)[idx]);
+		}
+    idx++;
+	}
+	vecW = std::move(BestW);
+	vecH = std::move(BestH);
+	if (backPtr) *backPtr = std::move(BestPtr);
+}
+
+/* Drop dominated points from a curve sorted by width, leaving a staircase
+	 with strictly decreasing heights. Of points with equal width only the
+	 lowest is kept */
+template<typename Coord>
+void paretoFilter(std::vector<Coord>& vecW, std::vector<Coord>& vecH, std::vector<BackPointer>* backPtr = nullptr)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < vecW.size(); i++)
+	{
+		if (kept > 0 && vecH[i] >= vecH[kept - 1]) continue;
+		if (kept > 0 && vecW[i] == vecW[kept - 1]) kept--;
+		vecW[kept] = vecW[i];
+		vecH[kept] = vecH[i];
+		if (backPtr) (*backPtr)[kept] = (*backPtr)[i];
+		kept++;
+	}
+	vecW.resize(kept);
+	vecH.resize(kept);
+	if (backPtr) backPtr->resize(kept);
+}
+
+/* Epsilon-dominance pruning of a staircase in one pass. Points are binned on
+	 a logarithmic grid with ratio r = 1 + epsilon in both W and H, and each
+	 cell keeps its point of least area. Any dropped point shares a cell with
+	 the kept one, so it is dominated within a factor r in both dimensions and
+	 its area within r^2. A monotone staircase crosses at most
+	 log_r(Wmax / Wmin) + log_r(Hmax / Hmin) + 1 cells, which bounds the
+	 curve size independent of the input. The two end points are always kept
+	 so the whole aspect range survives */
+template<typename Coord>
+void pruneEpsilonGrid(std::vector<Coord>& vecW, std::vector<Coord>& vecH, double epsilon, std::vector<BackPointer>* backPtr = nullptr)
+{
+	if (vecW.size() <= 2) return;
+	GST_PROFILE_PHASE(ProfilePhase::Prune);
+	double logStep = std::log1p(epsilon);
+	auto cell = [&](size_t i) {
+		return std::make_pair(std::floor(std::log(double(vecW[i])) / logStep), std::floor(std::log(double(vecH[i])) / logStep));
+	};
+
+	size_t const none = vecW.size();
+	size_t last = vecW.size() - 1;
+	size_t kept = 0;
+	auto keep = [&](size_t i) {
+		vecW[kept] = vecW[i];
+		vecH[kept] = vecH[i];
+		if (backPtr) (*backPtr)[kept] = (*backPtr)[i];
+		kept++;
+	};
+
+	/* Inner points come in runs of equal cells, keep the best of each run */
+	keep(0);
+	size_t best = none;
+	std::pair<double, double> runCell;
+	for (size_t i = 1; i < last; i++)
+	{
+		auto c = cell(i);
+		if (best != none && c == runCell)
+		{
+			if (AreaOf<Coord>(vecW[i]) * vecH[i] < AreaOf<Coord>(vecW[best]) * vecH[best]) best = i;
+			continue;
+		}
+		if (best != none) keep(best);
+		runCell = c;
+		best = i;
+	}
+	if (best != none) keep(best);
+	keep(last);
+
+	vecW.resize(kept);
+	vecH.resize(kept);
+	if (backPtr) backPtr->resize(kept);
+}
+
+/* Error-bounded simplification of a staircase. A point p is covered by q if
+	 q fits the box of p scaled by r = sqrt(1 + delta), so q is a buildable
+	 replacement for p of at most 1 + delta times its area. Along the
+	 staircase q covers a contiguous run around itself, so a greedy pass is
+	 optimal: from the first uncovered point keep the widest point that still
+	 covers it, then skip everything that one covers. Both ends are kept so
+	 the whole aspect range survives */
+template<typename Coord>
+void simplifyStaircase(std::vector<Coord>& vecW, std::vector<Coord>& vecH, double delta, std::vector<BackPointer>* backPtr = nullptr)
+{
+	if (vecW.size() <= 2) return;
+	GST_PROFILE_PHASE(ProfilePhase::Prune);
+	double const r = std::sqrt(1 + delta);
+	size_t const size = vecW.size();
+
+	size_t kept = 0;
+	auto keep = [&](size_t i) {
+		vecW[kept] = vecW[i];
+		vecH[kept] = vecH[i];
+		if (backPtr) (*backPtr)[kept] = (*backPtr)[i];
+		kept++;
+	};
+	/* First point not covered by point q, which lies before it */
+	auto skipCovered = [&](size_t q, size_t from) {
+		while (from < size && vecH[q] <= r * vecH[from]) from++;
+		return from;
+	};
+
+	keep(0);
+	size_t next = skipCovered(0, 1);
+	size_t q = 0;
+	while (next < size)
+	{
+		/* Widest point still covering next; its index only grows */
+		q = std::max(q, next);
+		while (q + 1 < size && vecW[q + 1] <= r * vecW[next]) q++;
+		keep(q);
+		next = skipCovered(q, q + 1);
+	}
+	if (q != size - 1) keep(size - 1);
+
+	vecW.resize(kept);
+	vecH.resize(kept);
+	if (backPtr) backPtr->resize(kept);
+}
+
+/* Drop the points of more than limit area. A curve with no point within
+	 the limit stays whole: the budget is too tight for it, and pruning it
+	 would leave only a guess for the nodes above */
+template<typename Coord>
+void pruneAreaAbove(std::vector<Coord>& vecW, std::vector<Coord>& vecH, double limit, std::vector<BackPointer>* backPtr = nullptr)
+{
+	GST_PROFILE_PHASE(ProfilePhase::Prune);
+	using Area = AreaOf<Coord>;
+	auto within = [&](size_t i) { return Area(vecW[i]) * vecH[i] <= limit; };
+	size_t first = 0;
+	while (first < vecW.size() && !within(first)) first++;
+	if (first == vecW.size()) return;
+	size_t kept = 0;
+	for (size_t i = first; i < vecW.size(); i++)
+	{
+		if (!within(i)) continue;
+		vecW[kept] = vecW[i];
+		vecH[kept] = vecH[i];
+		if (backPtr) (*backPtr)[kept] = (*backPtr)[i];
+		kept++;
+	}
+	vecW.resize(kept);
+	vecH.resize(kept);
+	if (backPtr) backPtr->resize(kept);
+}
+
+/* Drop the points beyond the upper bounds of range. With turned, points
+	 that fit turned by 90 degrees stay too, which keeps every point of a
+	 curve that is about to be flipped together with its mirror */
+template<typename Coord>
+void clipToRange(std::vector<Coord>& vecW, std::vector<Coord>& vecH, ShapeCurveRange const& range, bool turned = false, std::vector<BackPointer>* backPtr = nullptr)
+{
+	GST_PROFILE_PHASE(ProfilePhase::Prune);
+	size_t kept = 0;
+	for (size_t i = 0; i < vecW.size(); i++)
+	{
+		if (!range.fits(vecW[i], vecH[i], turned)) continue;
+		vecW[kept] = vecW[i];
+		vecH[kept] = vecH[i];
+		if (backPtr) (*backPtr)[kept] = (*backPtr)[i];
+		kept++;
+	}
+	vecW.resize(kept);
+	vecH.resize(kept);
+	if (backPtr) backPtr->resize(kept);
+}
+
+/* Bound the size of a combined curve as configured in the GST. A half curve
+	 keeps half the points, its mirror brings the rest. It also has to be a
+	 staircase, or its mirror would not be sorted by width */
+template<typename Coord>
+void pruneCurve(GST const& gst, std::vector<Coord>& vecW, std::vector<Coord>& vecH, std::vector<BackPointer>* backPtr = nullptr, bool half = false)
+{
+	switch (gst.prune)
+	{
+	case PruneMode::BestN:
+		if (half) paretoFilter(vecW, vecH, backPtr);
+		getBestN(vecW, vecH, half ? (gst.pruneN + 1) / 2 : gst.pruneN, backPtr);
+		break;
+	case PruneMode::EpsilonGrid:
+		paretoFilter(vecW, vecH, backPtr);
+		pruneEpsilonGrid(vecW, vecH, gst.pruneEpsilon, backPtr);
+		break;
+	case PruneMode::Simplify:
+		paretoFilter(vecW, vecH, backPtr);
+		simplifyStaircase(vecW, vecH, gst.pruneDelta, backPtr);
+		break;
+	}
+}
+
+/* Curves that are sorted by width and strictly falling in height. Leaves
+	 always are; combined curves only when pruning drops dominated points */
+inline bool isStaircase(GST const& gst, Subcircuit const& node)
+{
+	return node.is_leaf || node.is_implicit || node.is_symmetric || gst.prune != PruneMode::BestN;
+}
+
+/* Merge path split. Merging sequences of size and size2 where precedes(i, j)
+	 tells if element i of the first goes before element j of the second,
+	 returns how many elements of the first are among the first k merged */
+template<typename Precedes>
+size_t mergePathSplit(size_t k, size_t size, size_t size2, Precedes&& precedes)
+{
+	size_t lo = k > size2 ? k - size2 : 0;
+	size_t hi = std::min(k, size);
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (precedes(mid, k - mid - 1)) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+/* Number of slices a merge of total steps is split into on the GST's pool */
+inline size_t mergeSlices(GST const& gst, size_t total)
+{
+	if (!gst.pool || gst.parallelCombineMin == 0) return 1;
+	return std::max<size_t>(1, std::min<size_t>(2 * gst.pool->size(), total / gst.parallelCombineMin));
+}
+
+/* Run fn(begin, end, slice) over equal parts of the steps [0, total) */
+template<typename Fn>
+void forEachSlice(GST const& gst, size_t total, size_t slices, Fn&& fn)
+{
+	if (slices <= 1)
+	{
+		fn(size_t(0), total, size_t(0));
+		return;
+	}
+	gst.pool->parallelFor(slices, [&](size_t s) {
+		fn(total * s / slices, total * (s + 1) / slices, s);
+	});
+}
+
+/* Flip the curve and prune the result. Original and flipped points are
+	 merged by width; for large staircases the merge is cut into slices of
+	 equal length along its merge path, which run concurrently and write
+	 straight to their part of the result. With symmetricHalves only the
+	 w <= h half of the result is built: the original points up to the
+	 diagonal merged with the mirrors of the points after it, which is half
+	 the merge and prune work. staircase tells if the node's curve is one,
+	 which it is when both its children are */
+inline void flipCurve(Node n, GST& gst, bool staircase)
+{
+	GST_PROFILE_SCOPE(ProfilePhase::Flip, gst.nodes[n].level);
+	auto& originalCurveX = gst.nodes[n].shapeCurveX;
+	auto& originalCurveY = gst.nodes[n].shapeCurveY;
+	auto const& originalBackPtr = gst.nodes[n].backPtr;
+	bool const tracked = !originalBackPtr.empty();
+	bool const half = gst.symmetricHalves;
+	size_t size = originalCurveX.size();
+
+	/* The combined curve rises in width and falls in height, so the points
+		 with w <= h are a prefix. Its own points on the diagonal are already
+		 in the half and are not mirrored again */
+	size_t origCount = size, flipCount = size;
+	if (half)
+	{
+		size_t lo = 0, hi = size;
+		while (lo < hi)
+		{
+			size_t mid = (lo + hi) / 2;
+			if (originalCurveX[mid] <= originalCurveY[mid]) lo = mid + 1;
+			else hi = mid;
+		}
+		origCount = lo;
+		flipCount = size - origCount;
+	}
+	size_t total = origCount + flipCount;
+
+	VecCurve newCurveX(total);
+	VecCurve newCurveY(total);
+	std::vector<BackPointer> newBackPtr(tracked ? total : 0);
+
+	/* Flipped point t comes from original point size - 1 - t. Flipped points
+		 keep the child indices of their source point and are marked as vertical */
+	auto precedes = [&](size_t i, size_t t) {
+		return !(originalCurveX[i] > originalCurveY[size - 1 - t]);
+	};
+	auto mergeRange = [&](size_t begin, size_t end, size_t) {
+		size_t i = mergePathSplit(begin, origCount, flipCount, precedes);
+		size_t t = begin - i;
+		for (size_t k = begin; k < end; k++)
+		{
+			if (t >= flipCount || (i < origCount && precedes(i, t)))
+			{
+				newCurveX[k] = originalCurveX[i];
+				newCurveY[k] = originalCurveY[i];
+				if (tracked) newBackPtr[k] = originalBackPtr[i];
+				i++;
+			}
+			else
+			{
+				size_t j = size - 1 - t;
+				newCurveX[k] = originalCurveY[j];
+				newCurveY[k] = originalCurveX[j];
+				if (tracked) newBackPtr[k] = BackPointer(originalBackPtr[j].leftIdx(), originalBackPtr[j].rightIdx(), true);
+				t++;
+			}
+		}
+	};
+	forEachSlice(gst, total, staircase ? mergeSlices(gst, total) : 1, mergeRange);
+
+	/* Now each point is in the orientation it is used in, and the ones that
+		 do not fit go before pruning picks among them. A half curve stands for
+		 both orientations and is only clipped before the flip */
+	if (!gst.shapeRange.empty() && !half)
+	{
+		clipToRange(newCurveX, newCurveY, gst.shapeRange[n], false, tracked ? &newBackPtr : nullptr);
+	}
+
+	pruneCurve(gst, newCurveX, newCurveY, tracked ? &newBackPtr : nullptr, half);
+
+	gst.nodes[n].shapeCurveX = std::move(newCurveX);
+	gst.nodes[n].shapeCurveY = std::move(newCurveY);
+	gst.nodes[n].backPtr = std::move(newBackPtr);
+	gst.nodes[n].is_symmetric = half;
+}
+
+inline void flipCurve(Node n, GST& gst)
+{
+	flipCurve(n, gst, isStaircase(gst, gst.nodes[gst.leftChild[n]]) && isStaircase(gst, gst.nodes[gst.rightChild[n]]));
+}
+
+/* Store the full curve of a symmetric node, for consumers outside the GST
+	 like the writers of the root curve. Under a fixed outline the mirrored
+	 points that do not fit are left out */
+inline void expandSymmetric(Node n, GST& gst)
+{
+	auto& node = gst.nodes[n];
+	if (!node.is_symmetric) return;
+	FullCurve full(node);
+	VecCurve X(full.size()), Y(full.size());
+	std::vector<BackPointer> backPtr(full.bp ? full.size() : 0);
+	for (size_t k = 0; k < full.size(); k++)
+	{
+		X[k] = full.w(k);
+		Y[k] = full.h(k);
+		if (full.bp) backPtr[k] = full.backPtr(k);
+	}
+	if (!gst.shapeRange.empty()) clipToRange(X, Y, gst.shapeRange[n], false, full.bp ? &backPtr : nullptr);
+	node.shapeCurveX = std::move(X);
+	node.shapeCurveY = std::move(Y);
+	node.backPtr = std::move(backPtr);
+	node.is_symmetric = false;
+}
+
+/* Combine two implicit children in closed form. Side by side at a common
+	 height h the children take widths a1 / h and a2 / h, so the parent is
+	 (a1 + a2) / h on the overlap [lo, hi] of their height ranges, and the flip
+	 adds the same hyperbola on heights [A / hi, A / lo]. Where one child is
+	 already clamped to its range the parent only gets the dominated tails
+	 w = a1 / u1 + a2 / h, which the mirrored half beats as long as it reaches
+	 the highest child height. If the two halves also overlap, the parent is a
+	 single soft curve of area A and is stored implicitly. Returns false if the
+	 closed form does not apply and the children have to be sampled */
+inline bool combineImplicit(Subcircuit& node, Subcircuit const& left, Subcircuit const& right)
+{
+	if (!left.is_implicit || !right.is_implicit) return false;
+
+	double l1, u1, l2, u2;
+	softHeightRange(left, l1, u1);
+	softHeightRange(right, l2, u2);
+	double lo = std::max(l1, l2);
+	double hi = std::min(u1, u2);
+	if (lo > hi) return false;
+
+	double A = left.area + right.area;
+	double mirrorLo = A / hi;
+	double mirrorHi = A / lo;
+	if (std::max(lo, mirrorLo) > std::min(hi, mirrorHi)) return false;
+	if (std::max(u1, u2) > std::max(hi, mirrorHi)) return false;
+
+	double h_min = std::min(lo, mirrorLo);
+	double h_max = std::max(hi, mirrorHi);
+	node.area = A;
+	node.par1 = h_min * h_min / A;
+	node.par2 = h_max * h_max / A;
+	node.is_implicit = true;
+	return true;
+}
+
+/* Combine Curves of children of given node. This function can only be applied
+	 on internal sub-partitions. The children are read from left and right,
+	 which need not be nodes of the GST: callers that keep curves elsewhere
+	 combine them without copying them in. The GST's own child nodes are only
+	 written when back-pointers are recorded, to keep the samples of implicit
+	 children, so left and right have to be them then */
+inline void combineNode(Node n, GST& gst, Subcircuit const& left, Subcircuit const& right)
+{
+	if (gst.verbose) std::cout<<"Combining "<<n<<", "<<"merging Curve of node "<<gst.leftChild[n]<<" and "<<gst.rightChild[n]<<"\n";
+	assert((!gst.recordBackPointers || (&left == &gst.nodes[gst.leftChild[n]] && &right == &gst.nodes[gst.rightChild[n]]))
+		&& "Back-pointers need the children in the GST");
+	auto& node = gst.nodes[n];
+	node.level = std::max(left.level, right.level) + 1;
+	GST_PROFILE_SCOPE(ProfilePhase::Combine, node.level);
+	if (gst.verbose) std::cout<<"sizeLeftChild = "<<left.shapeCurveX.size()<<"\t"<<"sizeRightChild = "<<right.shapeCurveX.size()<<"\n";
+
+	/* Check if there has been curve in child */
+	if ((left.shapeCurveX.empty() && !left.is_implicit) || (right.shapeCurveX.empty() && !right.is_implicit))
+	{
+		std::cerr<<"Error when dealing node "<<n<<"\n";
+	}
+	/* Under a fixed outline a child without a shape that fits leaves none to
+		 its parent either */
+	bool const outlined = !gst.shapeRange.empty();
+	auto noShape = [&](Subcircuit const& child) { return child.shapeCurveX.empty() && !child.is_implicit; };
+	if (outlined && (noShape(left) || noShape(right)))
+	{
+		node.shapeCurveX.clear();
+		node.shapeCurveY.clear();
+		node.backPtr.clear();
+		return;
+	}
+	assert(!(left.shapeCurveX.empty() && !left.is_implicit) && !(right.shapeCurveX.empty() && !right.is_implicit)
+		&& "Curve of child is not computed yet");
+
+	if (combineImplicit(node, left, right))
+	{
+		if (gst.verbose) std::cout<<"combined in closed form, area = "<<node.area<<"\n";
+		return;
+	}
+
+	/* Implicit children are sampled just for this combine, at the resolution of
+		 the other child and within their range */
+	VecCurve sampledX[2], sampledY[2];
+	FullCurve L(left), R(right);
+	auto rangeOf = [&](Node child) { return outlined ? &gst.shapeRange[child] : nullptr; };
+	if (left.is_implicit)
+	{
+		GST_PROFILE_PHASE(ProfilePhase::LeafGeneration);
+		sampleImplicitLeaf(left, right.is_implicit ? nullptr : &R, sampledX[0], sampledY[0], gst.softPoints, rangeOf(gst.leftChild[n]));
+		L = FullCurve(sampledX[0], sampledY[0]);
+	}
+	if (right.is_implicit)
+	{
+		GST_PROFILE_PHASE(ProfilePhase::LeafGeneration);
+		sampleImplicitLeaf(right, &L, sampledX[1], sampledY[1], gst.softPoints, rangeOf(gst.rightChild[n]));
+		R = FullCurve(sampledX[1], sampledY[1]);
+	}
+	if (L.size() == 0 || R.size() == 0)
+	{
+		node.shapeCurveX.clear();
+		node.shapeCurveY.clear();
+		node.backPtr.clear();
+		return;
+	}
+
+	/* Both curves go from narrow-tall to wide-flat. Walk them together and
+		 always advance the child that bounds the height of the current point,
+		 the left one on ties. That is a merge of the two curves by falling
+		 height, so for staircases the walk can start at any step: the merge
+		 path gives the position, and the slices of a large combine run
+		 concurrently and are concatenated. A position that is not lower than
+		 the one before is only wider, so it is skipped. Children stored as
+		 half curves are read as full curves, their mirrored points made on
+		 the fly */
+	struct Slice
+	{
+		VecCurve X;
+		VecCurve Y;
+		std::vector<BackPointer> backPtr;
+	};
+	size_t lsize = L.size();
+	size_t rsize = R.size();
+	auto precedes = [&](size_t i, size_t j) { return L.h(i) >= R.h(j); };
+	auto sweepRange = [&](size_t begin, size_t end, Slice& out) {
+		size_t li = mergePathSplit(begin, lsize, rsize, precedes);
+		size_t ri = begin - li;
+		if (li >= lsize || ri >= rsize) return;
+
+		/* Height at the step before the slice */
+		double lastH = INFINITY;
+		if (begin > 0)
+		{
+			bool fromRight = li == 0 || (ri > 0 && precedes(li - 1, ri - 1));
+			lastH = fromRight ? std::max(L.h(li), R.h(ri - 1)) : std::max(L.h(li - 1), R.h(ri));
+		}
+		for (size_t k = begin; k < end && li < lsize && ri < rsize; k++)
+		{
+			double h = std::max(L.h(li), R.h(ri));
+			if (h < lastH)
+			{
+				out.X.push_back(L.w(li) + R.w(ri));
+				out.Y.push_back(h);
+				if (gst.recordBackPointers) out.backPtr.emplace_back(li, ri);
+			}
+			lastH = h;
+			if (precedes(li, ri)) li++;
+			else ri++;
+		}
+	};
+
+	bool sliced = isStaircase(gst, left) && isStaircase(gst, right);
+	size_t total = lsize + rsize;
+	size_t slices = sliced ? mergeSlices(gst, total) : 1;
+	if (slices <= 1)
+	{
+		Slice out;
+		sweepRange(0, total, out);
+		node.shapeCurveX = std::move(out.X);
+		node.shapeCurveY = std::move(out.Y);
+		node.backPtr = std::move(out.backPtr);
+	}
+	else
+	{
+		std::vector<Slice> parts(slices);
+		forEachSlice(gst, total, slices, [&](size_t begin, size_t end, size_t s) { sweepRange(begin, end, parts[s]); });
+		std::vector<size_t> offset(slices + 1, 0);
+		for (size_t s = 0; s < slices; s++) offset[s + 1] = offset[s] + parts[s].X.size();
+		node.shapeCurveX.resize(offset[slices]);
+		node.shapeCurveY.resize(offset[slices]);
+		if (gst.recordBackPointers) node.backPtr.resize(offset[slices]);
+		gst.pool->parallelFor(slices, [&](size_t s) {
+			auto const& part = parts[s];
+			std::copy(part.X.begin(), part.X.end(), node.shapeCurveX.begin() + offset[s]);
+			std::copy(part.Y.begin(), part.Y.end(), node.shapeCurveY.begin() + offset[s]);
+			if (gst.recordBackPointers) std::copy(part.backPtr.begin(), part.backPtr.end(), node.backPtr.begin() + offset[s]);
+		});
+	}
+
+	/* Mirrored points have the same area, so the bound applies before the flip */
+	if (!gst.areaLimit.empty())
+	{
+		pruneAreaAbove(node.shapeCurveX, node.shapeCurveY, gst.areaLimit[n], gst.recordBackPointers ? &node.backPtr : nullptr);
+	}
+	/* and so does the range, to the points that fit in one of the orientations */
+	if (outlined)
+	{
+		clipToRange(node.shapeCurveX, node.shapeCurveY, gst.shapeRange[n], true, gst.recordBackPointers ? &node.backPtr : nullptr);
+	}
+
+	/* Back-pointers refer to the sampled points, so keep them on the children */
+	if (gst.recordBackPointers)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			auto& child = gst.nodes[side == 0 ? gst.leftChild[n] : gst.rightChild[n]];
+			if (!child.is_implicit) continue;
+			child.shapeCurveX = std::move(sampledX[side]);
+			child.shapeCurveY = std::move(sampledY[side]);
+		}
+	}
+
+	flipCurve(n, gst, sliced);
+	if (gst.verbose) std::cout<<"sizeResultCurveSize = "<<node.shapeCurveX.size()<<"\n";
+}
+
+inline void combineNode(Node n, GST& gst)
+{
+	combineNode(n, gst, gst.nodes[gst.leftChild[n]], gst.nodes[gst.rightChild[n]]);
+}
+
+/* Sample the curve of an implicit node, typically a root that was combined
+	 entirely in closed form. The node stays implicit, so traces still split it
+	 analytically */
+inline void materializeImplicit(Node n, GST& gst, int num_points = 1000)
+{
+	auto& node = gst.nodes[n];
+	if (!node.is_implicit || !node.shapeCurveX.empty()) return;
+	sampleSoftCurve(node, node.shapeCurveX, node.shapeCurveY, num_points, gst.shapeRange.empty() ? nullptr : &gst.shapeRange[n]);
+}
+
+inline GST fakePartition()
+{
+	GST gst;
+	for (int i = 0; i < 7; i++)
+	{
+		gst.createPi({10, false, true, 0.1, 10});
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		gst.nodes.emplace_back();
+	}
+	for (int i = 0; i < 7; i++)
+	{
+		gst.leftChild.push_back(-1);
+		gst.rightChild.push_back(-1);
+	}
+	gst.leftChild.push_back(0);
+	gst.rightChild.push_back(1);
+	gst.leftChild.push_back(2);
+	gst.rightChild.push_back(3);
+	gst.leftChild.push_back(4);
+	gst.rightChild.push_back(5);
+	gst.leftChild.push_back(7);
+	gst.rightChild.push_back(8);
+	gst.leftChild.push_back(9);
+	gst.rightChild.push_back(6);
+	gst.leftChild.push_back(10);
+	gst.rightChild.push_back(11);
+	
+	return gst;
+}
+
+/* Print all coordinates of given node */
+inline void printCurve(Node n, GST& gst)
+{
+	for (auto p : curveView(gst.nodes[n]))
+	{
+		std::cout<<"x = "<<p.w<<", "<<"y = "<<p.h<<"\n";
+	}
+}
+
+/* Shape picked for a node when tracing a root point down the GST. point is
+	 the index in the node's curve, rotated tells if that point is used
+	 transposed, w and h are the realized dimensions. Children of a node
+	 combined in closed form have no point index, only their dimensions */
+struct ShapeChoice
+{
+	int point = -1;
+	bool rotated = false;
+	double w = 0;
+	double h = 0;
+	bool used = false;
+};
+
+/* Derive the choices of both children of an internal node from the node's
+	 own choice. Returns true if the children sit side by side, false if they
+	 are stacked */
+inline bool splitChoice(GST const& gst, Node n, ShapeChoice const& c, ShapeChoice& left, ShapeChoice& right)
+{
+	auto const& node = gst.nodes[n];
+
+	/* A closed form node is the hyperbola side by side on the children's
+		 common heights and stacked on its mirror */
+	if (node.is_implicit)
+	{
+		double lo, hi, lo2, hi2;
+		softHeightRange(gst.nodes[gst.leftChild[n]], lo, hi);
+		softHeightRange(gst.nodes[gst.rightChild[n]], lo2, hi2);
+		lo = std::max(lo, lo2);
+		hi = std::min(hi, hi2);
+		bool sideBySide = std::abs(c.h - std::clamp(c.h, lo, hi)) <= std::abs(c.w - std::clamp(c.w, lo, hi));
+		auto place = [&](Node child, ShapeChoice& out) {
+			double a = gst.nodes[child].area;
+			out = ShapeChoice();
+			out.used = true;
+			out.w = sideBySide ? a / c.h : c.w;
+			out.h = sideBySide ? c.h : a / c.w;
+		};
+		place(gst.leftChild[n], left);
+		place(gst.rightChild[n], right);
+		return sideBySide;
+	}
+
+	assert(!node.backPtr.empty() && size_t(c.point) < FullCurve(node).size() && "Curve was combined without back-pointers");
+
+	/* A vertical point is the transposed horizontal combination, so both
+		 children flip orientation with it */
+	BackPointer bp = FullCurve(node).backPtr(c.point);
+	bool childRotated = c.rotated != bp.isVertical();
+	auto pick = [&](Node child, int p, ShapeChoice& out) {
+		FullCurve childCurve(gst.nodes[child]);
+		out.point = p;
+		out.rotated = childRotated;
+		out.used = true;
+		out.w = childRotated ? childCurve.h(p) : childCurve.w(p);
+		out.h = childRotated ? childCurve.w(p) : childCurve.h(p);
+	};
+	pick(gst.leftChild[n], bp.leftIdx(), left);
+	pick(gst.rightChild[n], bp.rightIdx(), right);
+	return !childRotated;
+}
+
+/* Trace the given point of the root curve down to every node of its subtree.
+	 Requires the curves to be combined with recordBackPointers. Nodes are in
+	 topological order, so visiting them from the root downwards sees every
+	 parent before its children */
+inline std::vector<ShapeChoice> traceBack(GST const& gst, Node root, int point)
+{
+	std::vector<ShapeChoice> choice(gst.nodes.size());
+	auto& c = choice[root];
+	c.point = point;
+	c.used = true;
+	c.w = FullCurve(gst.nodes[root]).w(point);
+	c.h = FullCurve(gst.nodes[root]).h(point);
+
+	for (Node n = root; n >= gst.numPi; n--)
+	{
+		if (!choice[n].used) continue;
+		splitChoice(gst, n, choice[n], choice[gst.leftChild[n]], choice[gst.rightChild[n]]);
+	}
+	return choice;
+}
+#pragma endregion
+
+#pragma region foreach
+template<typename Fn>
+void foreach_pi(GST& gst, Fn&& fn)
+{
+	int idx = 0;
+	for (auto& node : gst.nodes)
+	{
+		if (idx >= gst.numPi) return;
+		else {
+			fn(idx);
+			idx++;
+		}
+	}
+}
+
+template<typename Fn>
+void foreach_node(GST& gst, Fn&& fn)
+{
+	int idx = 0;
+	for (auto& node : gst.nodes)
+	{		
+		fn(idx);
+		idx++;
+	}
+}
+
+template<typename Fn>
+void foreach_partition(GST& gst, Fn&& fn)
+{
+	int idx = 0;
+	for (auto& node : gst.nodes)
+	{		
+		if (idx < gst.numPi)
+		{
+			idx++;
+			continue;
+		}
+		fn(idx);
+		idx++;
+	}
+}
+#pragma endregion
+
+#pragma region Evaluation
+/* Run leafFn(n) on every leaf and nodeFn(n) on every internal node after
+	 both its children. Without a pool the nodes are visited in topological
+	 order. With one, leaves are generated in chunks and every internal node
+	 is spawned as soon as both its children are done, so independent
+	 subtrees combine concurrently. Nodes may have several parents, so a GST
+	 that shares subtrees is evaluated once. If nodeFn throws, the nodes not
+	 yet combined are skipped and the first exception is rethrown once no
+	 task is left */
+template<typename Leaf, typename Combine>
+void scheduleGST(GST const& gst, WorkStealingPool* workers, Leaf&& leafFn, Combine&& nodeFn)
+{
+	if (!workers)
+	{
+		for (Node n = 0; n < gst.numPi; n++) leafFn(n);
+		for (Node n = gst.numPi; n < Node(gst.nodes.size()); n++) nodeFn(n);
+		return;
+	}
+	auto& pool = *workers;
+
+	size_t const chunk = 1024;
+	pool.parallelFor((gst.numPi + chunk - 1) / chunk, [&](size_t c) {
+		size_t end = std::min<size_t>(gst.numPi, (c + 1) * chunk);
+		for (size_t n = c * chunk; n < end; n++) leafFn(n);
+	});
+
+	/* Parents of every node in compressed rows, and the number of children
+		 still to be combined per internal node */
+	int numNodes = gst.nodes.size();
+	std::vector<int> parentStart(numNodes + 1, 0);
+	for (Node n = gst.numPi; n < numNodes; n++)
+	{
+		parentStart[gst.leftChild[n] + 1]++;
+		parentStart[gst.rightChild[n] + 1]++;
+	}
+	for (int n = 0; n < numNodes; n++) parentStart[n + 1] += parentStart[n];
+	std::vector<Node> parents(parentStart[numNodes]);
+	std::vector<int> fill(parentStart.begin(), parentStart.end() - 1);
+	std::unique_ptr<std::atomic<int>[]> waiting(new std::atomic<int>[numNodes]);
+	for (Node n = gst.numPi; n < numNodes; n++)
+	{
+		parents[fill[gst.leftChild[n]]++] = n;
+		parents[fill[gst.rightChild[n]]++] = n;
+		waiting[n] = (gst.leftChild[n] >= gst.numPi) + (gst.rightChild[n] >= gst.numPi);
+	}
+
+	/* remaining is released last, after which the caller may return */
+	std::atomic<int> remaining(numNodes - gst.numPi);
+	std::mutex errorMutex;
+	std::exception_ptr error;
+	std::atomic<bool> failed(false);
+	std::function<void(Node)> combine = [&](Node n) {
+		if (!failed.load(std::memory_order_relaxed))
+		{
+			try
+			{
+				nodeFn(n);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error) error = std::current_exception();
+				failed.store(true, std::memory_order_relaxed);
+			}
+		}
+		for (int k = parentStart[n]; k < parentStart[n + 1]; k++)
+		{
+			Node p = parents[k];
+			if (waiting[p].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				pool.spawn([&combine, p]() { combine(p); });
+			}
+		}
+		remaining.fetch_sub(1, std::memory_order_release);
+	};
+
+	/* Collect the ready nodes first, spawned nodes already count down others */
+	std::vector<Node> ready;
+	for (Node n = gst.numPi; n < numNodes; n++)
+	{
+		if (waiting[n].load(std::memory_order_relaxed) == 0) ready.push_back(n);
+	}
+	for (Node n : ready) pool.spawn([&combine, n]() { combine(n); });
+	pool.waitUntil([&]() { return remaining.load(std::memory_order_acquire) == 0; });
+	if (error) std::rethrow_exception(error);
+}
+
+/* Largest area a point of each node can have and still be part of a root
+	 shape within the whitespace budget. The leaf areas summed up the tree are
+	 a lower bound lb of every node's area, so a root shape has at most
+	 (1 + whitespace) lb[root] area, and a point of a child has to leave room
+	 for the least area of its sibling: limit[child] = limit[parent] -
+	 lb[sibling]. Nodes shared by several parents take the largest limit.
+
+	 The least area of the sibling's actual curve would give a tighter limit,
+	 but it is only known once both children are combined. At that point it
+	 cannot shrink the child any more, and the child points it would drop
+	 only make parent points above limit[parent], since (wl + wr) max(hl, hr)
+	 >= wl hl + wr hr. The parent's own prune already drops those, so lb is
+	 used throughout */
+inline std::vector<double> areaLimits(GST const& gst)
+{
+	int numNodes = gst.nodes.size();
+	std::vector<double> lb(numNodes, 0);
+	std::vector<bool> hasParent(numNodes, false);
+	for (Node n = 0; n < gst.numPi; n++)
+	{
+		auto const& leaf = gst.nodes[n];
+		lb[n] = leaf.is_hard ? std::max(leaf.area, leaf.par1 * leaf.par2) : leaf.area;
+	}
+	for (Node n = gst.numPi; n < numNodes; n++)
+	{
+		lb[n] = lb[gst.leftChild[n]] + lb[gst.rightChild[n]];
+		hasParent[gst.leftChild[n]] = true;
+		hasParent[gst.rightChild[n]] = true;
+	}
+
+	/* Parents come after their children, so walking down visits them first */
+	std::vector<double> limit(numNodes, -INFINITY);
+	for (Node n = numNodes - 1; n >= gst.numPi; n--)
+	{
+		if (!hasParent[n]) limit[n] = (1 + gst.whitespace) * lb[n];
+		Node l = gst.leftChild[n], r = gst.rightChild[n];
+		limit[l] = std::max(limit[l], limit[n] - lb[r]);
+		limit[r] = std::max(limit[r], limit[n] - lb[l]);
+	}
+	return limit;
+}
+
+/* Shapes every node may take under the GST's outline. Bottom-up, the leaves
+	 give each subtree lower bounds: its least width W_min and height H_min,
+	 the least larger side of a shape and the least area. Top-down, a root
+	 gets the outline and a child what its parent leaves. The parent's points
+	 may be flipped into its box, so before the flip both their sides are
+	 bounded by the larger side c of the box, and the child, placed next to
+	 its sibling, has c - W_min[sibling] of width. Nodes shared by several
+	 parents take the largest bounds. Throws, before any curve is computed,
+	 if the lower bounds of a node do not fit its box */
+inline std::vector<ShapeCurveRange> shapeRanges(GST const& gst)
+{
+	int numNodes = gst.nodes.size();
+	std::vector<ShapeCurveRange> range(numNodes, ShapeCurveRange(0, -INFINITY, 0, -INFINITY));
+	std::vector<double> side(numNodes), area(numNodes);
+	std::vector<bool> hasParent(numNodes, false);
+	for (Node n = 0; n < gst.numPi; n++)
+	{
+		auto const& leaf = gst.nodes[n];
+		auto& r = range[n];
+		if (leaf.is_hard)
+		{
+			r.W_min = r.H_min = std::min(leaf.par1, leaf.par2);
+			side[n] = std::max(leaf.par1, leaf.par2);
+			area[n] = leaf.par1 * leaf.par2;
+			continue;
+		}
+		double x_min = std::sqrt(leaf.area / leaf.par2);
+		double x_max = std::sqrt(leaf.area / leaf.par1);
+		double x = std::min(std::max(std::sqrt(leaf.area), x_min), x_max);
+		r.W_min = x_min;
+		r.H_min = std::sqrt(leaf.area * leaf.par1);
+		side[n] = std::max(x, leaf.area / x);
+		area[n] = leaf.area;
+	}
+	for (Node n = gst.numPi; n < numNodes; n++)
+	{
+		Node l = gst.leftChild[n], r = gst.rightChild[n];
+		double width = range[l].W_min + range[r].W_min;
+		double height = std::max(range[l].H_min, range[r].H_min);
+		range[n].W_min = range[n].H_min = std::min(width, height);
+		side[n] = std::max({side[l], side[r], width, height});
+		area[n] = area[l] + area[r];
+		hasParent[l] = true;
+		hasParent[r] = true;
+	}
+
+	/* The slack absorbs the rounding of sums of widths that exactly fill the
+		 outline */
+	double const slack = 1 + 1e-9;
+	for (Node n = numNodes - 1; n >= 0; n--)
+	{
+		auto& box = range[n];
+		if (!hasParent[n])
+		{
+			box.W_max = gst.outlineW * slack;
+			box.H_max = gst.outlineH * slack;
+		}
+		double c = std::max(box.W_max, box.H_max);
+		if (box.W_min > box.W_max || box.H_min > box.H_max || side[n] > c || area[n] > box.W_max * box.H_max)
+		{
+			throw std::runtime_error("fixed outline " + std::to_string(gst.outlineW) + " x " + std::to_string(gst.outlineH)
+				+ " is infeasible: node " + std::to_string(n) + " has no shape within "
+				+ std::to_string(box.W_max) + " x " + std::to_string(box.H_max));
+		}
+		if (n < gst.numPi) continue;
+		Node l = gst.leftChild[n], r = gst.rightChild[n];
+		range[l].W_max = std::max(range[l].W_max, c - range[r].W_min);
+		range[l].H_max = std::max(range[l].H_max, c);
+		range[r].W_max = std::max(range[r].W_max, c - range[l].W_min);
+		range[r].H_max = std::max(range[r].H_max, c);
+	}
+	return range;
+}
+
+/* Under a fixed outline, throw naming the first node that was left without
+	 a shape that fits; the nodes above it have none either */
+template<typename NoShape>
+void checkOutline(GST const& gst, NoShape&& noShape)
+{
+	for (Node n = 0; n < Node(gst.nodes.size()); n++)
+	{
+		if (noShape(n)) throw std::runtime_error("fixed outline is infeasible: node " + std::to_string(n) + " has no shape that fits");
+	}
+}
+
+/* Compute the curves of every node on the GST's pool. Near the root, where
+	 there is little left to overlap, the large combines slice their own
+	 sweeps */
+inline void evaluateGST(GST& gst, int num_points = 1000)
+{
+	gst.softPoints = num_points;
+	if (gst.whitespace >= 0) gst.areaLimit = areaLimits(gst);
+	if (gst.outlineW > 0 && gst.outlineH > 0) gst.shapeRange = shapeRanges(gst);
+	scheduleGST(gst, gst.pool, [&](Node n) { generatePoints(n, gst, num_points); }, [&](Node n) { combineNode(n, gst); });
+	if (!gst.shapeRange.empty())
+	{
+		checkOutline(gst, [&](Node n) { return gst.nodes[n].shapeCurveX.empty() && !gst.nodes[n].is_implicit; });
+	}
+}
+#pragma endregion
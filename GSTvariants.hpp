@@ -0,0 +1,128 @@
+#pragma once
+
+#include "GSTrevise.hpp"
+#include <unordered_map>
+
+#pragma region GSTVariants
+/* Internal nodes of one slicing tree over the leaves of a batch, laid out
+	 like GST::leftChild and GST::rightChild: entries of leaves are ignored and
+	 the nodes are in topological order with the root last */
+struct Topology
+{
+	std::vector<Node> leftChild;
+	std::vector<Node> rightChild;
+};
+
+/* Many trees over one leaf set, merged into a single GST that is a DAG. The
+	 leaves are stored once and every subtree that occurs in several trees is
+	 a single node, so its curve is generated or combined only once. The
+	 combination does not depend on the order of the two children, so a node
+	 is keyed by its unordered pair of children and a subtree also matches its
+	 mirror image. Each tree keeps a map from its own nodes to the DAG's, and
+	 traceBack and realizePlacement work on the DAG from any of the roots */
+struct GSTBatch
+{
+	GST dag;
+	std::vector<Node> roots;
+	std::vector<std::vector<Node>> nodeMap;
+	std::unordered_map<uint64_t, Node> unique;
+};
+
+/* Start a batch with the leaves and the settings of gst */
+inline GSTBatch makeBatch(GST const& gst)
+{
+	GSTBatch batch;
+	GST& dag = batch.dag;
+	dag.recordBackPointers = gst.recordBackPointers;
+	dag.verbose = gst.verbose;
+	dag.lazySoftLeaves = gst.lazySoftLeaves;
+	dag.prune = gst.prune;
+	dag.pruneN = gst.pruneN;
+	dag.pruneEpsilon = gst.pruneEpsilon;
+	dag.pruneDelta = gst.pruneDelta;
+	dag.pool = gst.pool;
+	dag.parallelCombineMin = gst.parallelCombineMin;
+	dag.symmetricHalves = gst.symmetricHalves;
+	dag.whitespace = gst.whitespace;
+	dag.outlineW = gst.outlineW;
+	dag.outlineH = gst.outlineH;
+	for (Node n = 0; n < gst.numPi; n++)
+	{
+		dag.createPi(gst.nodes[n]);
+		dag.leftChild.push_back(-1);
+		dag.rightChild.push_back(-1);
+	}
+	return batch;
+}
+
+inline Topology topologyOf(GST const& gst)
+{
+	return {gst.leftChild, gst.rightChild};
+}
+
+/* Merge one more tree into the batch and return its root in the DAG */
+inline Node addTopology(GSTBatch& batch, Topology const& topo)
+{
+	GST& dag = batch.dag;
+	std::vector<Node> map(topo.leftChild.size());
+	for (Node n = 0; n < dag.numPi; n++) map[n] = n;
+	for (Node n = dag.numPi; n < Node(topo.leftChild.size()); n++)
+	{
+		Node l = map[topo.leftChild[n]];
+		Node r = map[topo.rightChild[n]];
+		if (l > r) std::swap(l, r);
+		uint64_t key = (uint64_t(l) << 32) | uint32_t(r);
+		auto it = batch.unique.find(key);
+		if (it == batch.unique.end())
+		{
+			dag.nodes.emplace_back();
+			dag.leftChild.push_back(l);
+			dag.rightChild.push_back(r);
+			it = batch.unique.emplace(key, Node(dag.nodes.size() - 1)).first;
+		}
+		map[n] = it->second;
+	}
+	batch.roots.push_back(map.back());
+	batch.nodeMap.push_back(std::move(map));
+	return batch.roots.back();
+}
+
+/* Compute the curves of all trees of the batch on the DAG's pool.
+	 Back-pointers and lazy soft leaves do not mix here: a shared implicit
+	 leaf would need one set of samples per parent to keep its back-pointers
+	 valid. With recordBackPointers set, the batch therefore turns
+	 dag.lazySoftLeaves off, and leaves it off, and samples every soft leaf
+	 up front. A verbose DAG says so on std::cerr */
+inline void evaluateBatch(GSTBatch& batch, int num_points = 1000)
+{
+	GST& dag = batch.dag;
+	if (dag.recordBackPointers && dag.lazySoftLeaves)
+	{
+		if (dag.verbose) std::cerr<<"evaluateBatch: back-pointers are recorded, sampling soft leaves eagerly\n";
+		dag.lazySoftLeaves = false;
+	}
+	evaluateGST(dag, num_points);
+}
+
+/* Tree and root point of least area over the whole batch. A mirrored point
+	 has the area of its stored twin, so half curves need no expanding */
+inline std::pair<int, int> bestVariant(GSTBatch const& batch)
+{
+	std::pair<int, int> best{-1, -1};
+	double bestArea = INFINITY;
+	for (int t = 0; t < int(batch.roots.size()); t++)
+	{
+		auto const& root = batch.dag.nodes[batch.roots[t]];
+		for (int p = 0; p < int(root.shapeCurveX.size()); p++)
+		{
+			double area = root.shapeCurveX[p] * root.shapeCurveY[p];
+			if (area < bestArea)
+			{
+				bestArea = area;
+				best = {t, p};
+			}
+		}
+	}
+	return best;
+}
+#pragma endregion
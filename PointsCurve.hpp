@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/* Curve operators of the standalone tools (tree4.cpp, tree5.cpp,
+	 unit_test.cpp). A curve is a list of (w, h) points running from
+	 narrow-tall to wide-flat; a parent curve is
+	 merging(addition(A, B), flipping(addition(A, B))) */
+typedef std::vector<std::pair<double, double>> Points;
+
+/* Side by side. At a height y each curve needs the width of its first point
+	 that is not taller than y, so the sum is again a staircase with its
+	 corners at the heights of A and B. Walk both curves once, always moving
+	 past the point that sets the current height, and emit one point per
+	 corner */
+inline Points addition(Points const& curveA, Points const& curveB)
+{
+	Points Ch;
+	Ch.reserve(curveA.size() + curveB.size());
+	auto itA = curveA.begin();
+	auto itB = curveB.begin();
+	while (itA != curveA.end() && itB != curveB.end())
+	{
+		double x = itA->first + itB->first;
+		double y = std::max(itA->second, itB->second);
+		if (Ch.empty() || y < Ch.back().second) Ch.push_back({x, y});
+
+		if (itA->second > itB->second) ++itA;
+		else if (itB->second > itA->second) ++itB;
+		else
+		{
+			++itA;
+			++itB;
+		}
+	}
+	return Ch;
+}
+
+/* Transpose of every point. The result keeps the order of Ch, so it runs
+	 from wide-flat to narrow-tall */
+inline Points flipping(Points const& curveCh)
+{
+	Points Cv;
+	Cv.reserve(curveCh.size());
+	for (auto const& p : curveCh) Cv.push_back({p.second, p.first});
+	return Cv;
+}
+
+/* Lower envelope of Ch and its transpose Cv as returned by flipping. Walking
+	 Cv backwards puts both curves in order of width; take the narrower point
+	 of the two, the lower one on equal widths, and keep it if it is lower
+	 than the last point kept */
+inline Points merging(Points const& curveCh, Points const& curveCv)
+{
+	Points C;
+	C.reserve(curveCh.size() + curveCv.size());
+	auto itCh = curveCh.begin();
+	auto itCv = curveCv.rbegin();
+	while (itCh != curveCh.end() || itCv != curveCv.rend())
+	{
+		bool fromCh = itCv == curveCv.rend() || (itCh != curveCh.end() && (itCh->first < itCv->first ||
+			(itCh->first == itCv->first && itCh->second <= itCv->second)));
+		auto const& p = fromCh ? *itCh++ : *itCv++;
+		if (C.empty() || p.second < C.back().second) C.push_back(p);
+	}
+	return C;
+}
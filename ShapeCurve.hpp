@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#pragma region ShapeCurve
+/* Curve container for handing curves between stages. A curve is a
+	 sequence of (w, h) points; ShapeCurve owns one, CurveView reads one
+	 without owning it.
+
+	 SoA keeps all widths, then all heights, the layout of a GST node. AoS
+	 interleaves w and h, the layout of the text and binary files. Both hand
+	 their vectors out, so a curve moves in and out of a GST node, a parse
+	 buffer or the host side of a GPU copy without being copied.
+
+	 No kernel takes the type. The combine, flip and prune kernels index the
+	 split vectors of the nodes, the GPU sampler writes raw device buffers,
+	 and the tree*.cpp tools keep their own point types, which the fuzzer
+	 copies at the boundary. A view steps through a single array, so it sits
+	 on split vectors or on one interleaved buffer, never across the members
+	 of a struct */
+enum class CurveLayout
+{
+	SoA,
+	AoS
+};
+
+template<typename Scalar>
+struct CurvePoint
+{
+	Scalar w;
+	Scalar h;
+};
+
+template<typename Scalar>
+class CurveView
+{
+public:
+	class iterator
+	{
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = CurvePoint<Scalar>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = CurvePoint<Scalar>;
+
+		iterator() = default;
+		iterator(Scalar const* w, Scalar const* h, size_t stride, size_t i) : w_(w), h_(h), stride_(stride), i_(i) {}
+
+		CurvePoint<Scalar> operator*() const { return {w_[i_ * stride_], h_[i_ * stride_]}; }
+		CurvePoint<Scalar> operator[](difference_type k) const { return *(*this + k); }
+
+		iterator& operator++() { i_++; return *this; }
+		iterator operator++(int) { iterator t = *this; i_++; return t; }
+		iterator& operator--() { i_--; return *this; }
+		iterator operator--(int) { iterator t = *this; i_--; return t; }
+		iterator& operator+=(difference_type k) { i_ += k; return *this; }
+		iterator& operator-=(difference_type k) { i_ -= k; return *this; }
+		iterator operator+(difference_type k) const { return {w_, h_, stride_, i_ + k}; }
+		iterator operator-(difference_type k) const { return {w_, h_, stride_, i_ - k}; }
+		friend iterator operator+(difference_type k, iterator it) { return it + k; }
+		difference_type operator-(iterator o) const { return difference_type(i_) - difference_type(o.i_); }
+
+		bool operator==(iterator o) const { return i_ == o.i_; }
+		bool operator!=(iterator o) const { return i_ != o.i_; }
+		bool operator<(iterator o) const { return i_ < o.i_; }
+		bool operator>(iterator o) const { return i_ > o.i_; }
+		bool operator<=(iterator o) const { return i_ <= o.i_; }
+		bool operator>=(iterator o) const { return i_ >= o.i_; }
+
+	private:
+		/* Copied from the view, so iterators outlive a temporary view */
+		Scalar const* w_ = nullptr;
+		Scalar const* h_ = nullptr;
+		size_t stride_ = 1;
+		size_t i_ = 0;
+	};
+
+	CurveView() = default;
+	/* Point i is (w[i * stride], h[i * stride]); stride counts Scalars. With
+		 a stride above 1, w and h must point into the same array */
+	CurveView(Scalar const* w, Scalar const* h, size_t size, size_t stride = 1) :
+		w_(w), h_(h), size_(size), stride_(stride) {}
+
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	size_t stride() const { return stride_; }
+
+	Scalar w(size_t i) const { return w_[i * stride_]; }
+	Scalar h(size_t i) const { return h_[i * stride_]; }
+	CurvePoint<Scalar> operator[](size_t i) const { return {w(i), h(i)}; }
+	CurvePoint<Scalar> front() const { return (*this)[0]; }
+	CurvePoint<Scalar> back() const { return (*this)[size_ - 1]; }
+
+	/* Widths and heights as plain arrays, only for SoA data */
+	bool contiguous() const { return stride_ == 1; }
+	Scalar const* widths() const { assert(contiguous()); return w_; }
+	Scalar const* heights() const { assert(contiguous()); return h_; }
+
+	/* Points [first, first + count) */
+	CurveView subview(size_t first, size_t count) const
+	{
+		return {w_ + first * stride_, h_ + first * stride_, count, stride_};
+	}
+
+	iterator begin() const { return {w_, h_, stride_, 0}; }
+	iterator end() const { return {w_, h_, stride_, size_}; }
+
+private:
+	Scalar const* w_ = nullptr;
+	Scalar const* h_ = nullptr;
+	size_t size_ = 0;
+	size_t stride_ = 1;
+};
+
+template<typename Scalar, CurveLayout Layout = CurveLayout::SoA>
+class ShapeCurve
+{
+public:
+	static constexpr bool kSoA = Layout == CurveLayout::SoA;
+
+	ShapeCurve() = default;
+	explicit ShapeCurve(size_t size) { resize(size); }
+
+	/* Take over split width and height vectors of equal size */
+	template<CurveLayout L = Layout, typename = std::enable_if_t<L == CurveLayout::SoA>>
+	ShapeCurve(std::vector<Scalar> w, std::vector<Scalar> h) : w_(std::move(w)), h_(std::move(h))
+	{
+		assert(w_.size() == h_.size());
+	}
+
+	/* Take over interleaved w h values, like a parsed two column file */
+	template<CurveLayout L = Layout, typename = std::enable_if_t<L == CurveLayout::AoS>>
+	explicit ShapeCurve(std::vector<Scalar> wh) : w_(std::move(wh))
+	{
+		assert(w_.size() % 2 == 0);
+	}
+
+	/* Copy of any view, converting the scalar type. This is the one place a
+		 curve changes representation */
+	template<typename Other>
+	explicit ShapeCurve(CurveView<Other> const& v) { assign(v); }
+
+	template<typename Other>
+	void assign(CurveView<Other> const& v)
+	{
+		resize(v.size());
+		for (size_t i = 0; i < v.size(); i++)
+		{
+			w(i) = Scalar(v.w(i));
+			h(i) = Scalar(v.h(i));
+		}
+	}
+
+	size_t size() const { return kSoA ? w_.size() : w_.size() / 2; }
+	bool empty() const { return w_.empty(); }
+
+	void reserve(size_t size)
+	{
+		if (kSoA)
+		{
+			w_.reserve(size);
+			h_.reserve(size);
+		}
+		else w_.reserve(2 * size);
+	}
+
+	void resize(size_t size)
+	{
+		if (kSoA)
+		{
+			w_.resize(size);
+			h_.resize(size);
+		}
+		else w_.resize(2 * size);
+	}
+
+	void clear()
+	{
+		w_.clear();
+		h_.clear();
+	}
+
+	void push_back(Scalar w, Scalar h)
+	{
+		w_.push_back(w);
+		(kSoA ? h_ : w_).push_back(h);
+	}
+
+	Scalar& w(size_t i) { return kSoA ? w_[i] : w_[2 * i]; }
+	Scalar& h(size_t i) { return kSoA ? h_[i] : w_[2 * i + 1]; }
+	Scalar w(size_t i) const { return kSoA ? w_[i] : w_[2 * i]; }
+	Scalar h(size_t i) const { return kSoA ? h_[i] : w_[2 * i + 1]; }
+	CurvePoint<Scalar> operator[](size_t i) const { return {w(i), h(i)}; }
+
+	/* Storage of an SoA curve, for kernels and copies to and from the GPU */
+	template<CurveLayout L = Layout, typename = std::enable_if_t<L == CurveLayout::SoA>>
+	std::vector<Scalar>& widths() { return w_; }
+	template<CurveLayout L = Layout, typename = std::enable_if_t<L == CurveLayout::SoA>>
+	std::vector<Scalar>& heights() { return h_; }
+	template<CurveLayout L = Layout, typename = std::enable_if_t<L == CurveLayout::SoA>>
+	std::vector<Scalar> const& widths() const { return w_; }
+	template<CurveLayout L = Layout, typename = std::enable_if_t<L == CurveLayout::SoA>>
+	std::vector<Scalar> const& heights() const { return h_; }
+
+	/* Hand the storage of an SoA curve to split vectors, leaving it empty */
+	template<CurveLayout L = Layout, typename = std::enable_if_t<L == CurveLayout::SoA>>
+	void release(std::vector<Scalar>& w, std::vector<Scalar>& h)
+	{
+		w = std::move(w_);
+		h = std::move(h_);
+		clear();
+	}
+
+	CurveView<Scalar> view() const
+	{
+		if (kSoA) return {w_.data(), h_.data(), size(), 1};
+		return {w_.data(), w_.data() + 1, size(), 2};
+	}
+	operator CurveView<Scalar>() const { return view(); }
+
+private:
+	/* SoA: widths in w_, heights in h_. AoS: w h pairs in w_ */
+	std::vector<Scalar> w_;
+	std::vector<Scalar> h_;
+};
+
+/* Zero-copy view over split width and height vectors */
+template<typename Scalar>
+CurveView<Scalar> curveView(std::vector<Scalar> const& w, std::vector<Scalar> const& h)
+{
+	assert(w.size() == h.size());
+	return {w.data(), h.data(), w.size(), 1};
+}
+
+template<typename Scalar, CurveLayout Layout>
+CurveView<Scalar> curveView(ShapeCurve<Scalar, Layout> const& curve)
+{
+	return curve.view();
+}
+#pragma endregion
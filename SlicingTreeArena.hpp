@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* Slicing tree stored flat. Nodes are plain records in one vector and refer
+	 to their children by 32-bit index; the child lists of all nodes share one
+	 index vector. A node is added after its children, so the nodes are in
+	 bottom-up order, the root is the last one, and evaluating the tree is a
+	 scan over the node vector. Curves are stored in large blocks shared by
+	 all nodes, so building and destroying a tree takes a few allocations no
+	 matter how many nodes it has. Point is the curve point type of the tool
+	 using the tree */
+template<typename Point>
+class SlicingTreeArena
+{
+public:
+	struct NodeRecord
+	{
+		uint32_t firstChild = 0;
+		uint32_t numChildren = 0;
+		Point const* curve = nullptr;
+		uint32_t curveSize = 0;
+		bool isHorizontal = false;
+		bool isSubcircuit = false;
+	};
+
+	/* Contiguous, read-only range of points */
+	struct CurveView
+	{
+		Point const* first = nullptr;
+		Point const* last = nullptr;
+
+		Point const* begin() const { return first; }
+		Point const* end() const { return last; }
+		size_t size() const { return last - first; }
+		bool empty() const { return first == last; }
+		Point const& operator[](size_t i) const { return first[i]; }
+	};
+
+	/* Points per curve block. Larger curves get a block of their own */
+	static constexpr size_t kBlockPoints = 1 << 16;
+
+	SlicingTreeArena() = default;
+	SlicingTreeArena(SlicingTreeArena const&) = delete;
+	SlicingTreeArena& operator=(SlicingTreeArena const&) = delete;
+	SlicingTreeArena(SlicingTreeArena&&) = default;
+	SlicingTreeArena& operator=(SlicingTreeArena&&) = default;
+
+	void reserve(size_t nodes, size_t children)
+	{
+		nodes_.reserve(nodes);
+		children_.reserve(children);
+	}
+
+	/* Leaf holding the curve [first, last) */
+	template<typename It>
+	uint32_t addLeaf(It first, It last)
+	{
+		uint32_t n = nodes_.size();
+		nodes_.emplace_back();
+		nodes_.back().isSubcircuit = true;
+		setCurve(n, first, last);
+		return n;
+	}
+
+	/* Internal node over children that are already in the tree */
+	template<typename It>
+	uint32_t addNode(It firstChild, It lastChild, bool isHorizontal = false)
+	{
+		NodeRecord record;
+		record.firstChild = children_.size();
+		record.isHorizontal = isHorizontal;
+		for (It it = firstChild; it != lastChild; ++it) children_.push_back(*it);
+		record.numChildren = children_.size() - record.firstChild;
+		nodes_.push_back(record);
+		return nodes_.size() - 1;
+	}
+
+	uint32_t addNode(std::initializer_list<uint32_t> children, bool isHorizontal = false)
+	{
+		return addNode(children.begin(), children.end(), isHorizontal);
+	}
+
+	/* Store the curve of node n. Different nodes may be set from different
+		 threads at the same time; a curve that is set again leaves its old
+		 points in the arena until the tree is destroyed */
+	template<typename It>
+	void setCurve(uint32_t n, It first, It last)
+	{
+		size_t size = std::distance(first, last);
+		Point* dst = allocate(size);
+		std::copy(first, last, dst);
+		nodes_[n].curve = dst;
+		nodes_[n].curveSize = size;
+	}
+
+	size_t size() const { return nodes_.size(); }
+	bool empty() const { return nodes_.empty(); }
+	uint32_t root() const { return nodes_.size() - 1; }
+
+	NodeRecord const& node(uint32_t n) const { return nodes_[n]; }
+	uint32_t numChildren(uint32_t n) const { return nodes_[n].numChildren; }
+	uint32_t child(uint32_t n, uint32_t k) const { return children_[nodes_[n].firstChild + k]; }
+	bool isLeaf(uint32_t n) const { return nodes_[n].numChildren == 0; }
+
+	CurveView curve(uint32_t n) const
+	{
+		auto const& r = nodes_[n];
+		return {r.curve, r.curve + r.curveSize};
+	}
+
+private:
+	Point* allocate(size_t size)
+	{
+		std::lock_guard<std::mutex> lock(*mutex_);
+		if (size > kBlockPoints)
+		{
+			blocks_.emplace_back(new Point[size]);
+			return blocks_.back().get();
+		}
+		if (!current_ || blockUsed_ + size > kBlockPoints)
+		{
+			blocks_.emplace_back(new Point[kBlockPoints]);
+			current_ = blocks_.back().get();
+			blockUsed_ = 0;
+		}
+		Point* p = current_ + blockUsed_;
+		blockUsed_ += size;
+		return p;
+	}
+
+	std::vector<NodeRecord> nodes_;
+	std::vector<uint32_t> children_;
+	std::vector<std::unique_ptr<Point[]>> blocks_;
+	Point* current_ = nullptr;
+	size_t blockUsed_ = 0;
+	std::unique_ptr<std::mutex> mutex_ = std::make_unique<std::mutex>();
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/* Fork-join thread pool with one task deque per worker. A worker pushes and
+	 pops its own tasks at the head, so it keeps working on the data it just
+	 touched, while idle workers steal from the tail, where the oldest and
+	 usually largest tasks are. The thread that waits for a task helps running
+	 tasks instead of blocking, so nested spawn/wait never deadlocks.
+	 An exception thrown by a task is kept on the task and rethrown by wait.
+	 One that nobody waited for when the last handle of its task is dropped
+	 is rethrown by the next waitUntil on the pool, so handles must not
+	 outlive the pool */
+class WorkStealingPool
+{
+public:
+	struct Task
+	{
+		std::function<void()> fn;
+		std::atomic<bool> done{false};
+		std::exception_ptr error;
+		/* Set by wait; the release of the last handle orders it before the
+			 destructor */
+		bool waited = false;
+		WorkStealingPool* pool = nullptr;
+
+		~Task()
+		{
+			if (error && !waited) pool->recordOrphan(error);
+		}
+	};
+	using TaskHandle = std::shared_ptr<Task>;
+
+	explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency())
+	{
+		if (threads == 0) threads = 1;
+		/* Slot 0 is shared by all threads outside the pool */
+		queues_.resize(threads);
+		for (auto& q : queues_) q = std::make_unique<Queue>();
+		for (unsigned i = 1; i < threads; i++)
+		{
+			workers_.emplace_back([this, i]() { workerLoop(i); });
+		}
+	}
+
+	~WorkStealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex_);
+			stop_ = true;
+		}
+		sleepCv_.notify_all();
+		for (auto& t : workers_) t.join();
+	}
+
+	WorkStealingPool(WorkStealingPool const&) = delete;
+	WorkStealingPool& operator=(WorkStealingPool const&) = delete;
+
+	unsigned size() const { return queues_.size(); }
+
+	/* Queue fn on the calling worker's deque and return a handle to wait on */
+	TaskHandle spawn(std::function<void()> fn)
+	{
+		auto task = std::make_shared<Task>();
+		task->fn = std::move(fn);
+		task->pool = this;
+		auto& q = *queues_[self()];
+		{
+			std::lock_guard<std::mutex> lock(q.mutex);
+			q.tasks.push_front(task);
+		}
+		pending_.fetch_add(1, std::memory_order_release);
+		sleepCv_.notify_one();
+		return task;
+	}
+
+	/* Run other tasks until the given one is finished, and rethrow what it
+		 threw */
+	void wait(TaskHandle const& task)
+	{
+		unsigned me = self();
+		while (!task->done.load(std::memory_order_acquire))
+		{
+			if (!runOne(me)) std::this_thread::yield();
+		}
+		if (!task->error) return;
+		task->waited = true;
+		std::rethrow_exception(task->error);
+	}
+
+	/* Run tasks until done() holds, for work that is spawned without handles.
+		 Throws the first exception of such a task as soon as it is seen, so
+		 work whose tasks share the caller's state should catch its own */
+	template<typename Pred>
+	void waitUntil(Pred&& done)
+	{
+		unsigned me = self();
+		while (!done())
+		{
+			rethrowOrphan();
+			if (!runOne(me)) std::this_thread::yield();
+		}
+		rethrowOrphan();
+	}
+
+	/* Run fn(0) .. fn(count - 1) as tasks and wait for all of them. The first
+		 exception is rethrown once every call has finished */
+	template<typename Fn>
+	void parallelFor(size_t count, Fn&& fn)
+	{
+		if (count == 0) return;
+		std::vector<TaskHandle> tasks;
+		tasks.reserve(count - 1);
+		for (size_t i = 1; i < count; i++)
+		{
+			tasks.push_back(spawn([&fn, i]() { fn(i); }));
+		}
+		std::exception_ptr error;
+		try
+		{
+			fn(0);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+		for (auto& t : tasks)
+		{
+			try
+			{
+				wait(t);
+			}
+			catch (...)
+			{
+				if (!error) error = std::current_exception();
+			}
+		}
+		if (error) std::rethrow_exception(error);
+	}
+
+	/* Run fn on the pool and wait for it. fn may spawn and wait on more tasks */
+	void run(std::function<void()> fn)
+	{
+		wait(spawn(std::move(fn)));
+	}
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<TaskHandle> tasks;
+	};
+
+	/* Queue of the calling thread. A worker of one pool may call into
+		 another, so its index is only taken by the pool it belongs to; every
+		 other thread uses queue 0 */
+	struct Worker
+	{
+		WorkStealingPool const* pool = nullptr;
+		unsigned index = 0;
+	};
+
+	static Worker& currentWorker()
+	{
+		static thread_local Worker worker;
+		return worker;
+	}
+
+	unsigned self() const
+	{
+		auto const& worker = currentWorker();
+		return worker.pool == this ? worker.index : 0;
+	}
+
+	TaskHandle popHead(unsigned i)
+	{
+		auto& q = *queues_[i];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (q.tasks.empty()) return nullptr;
+		auto task = std::move(q.tasks.front());
+		q.tasks.pop_front();
+		return task;
+	}
+
+	TaskHandle stealTail(unsigned i)
+	{
+		auto& q = *queues_[i];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (q.tasks.empty()) return nullptr;
+		auto task = std::move(q.tasks.back());
+		q.tasks.pop_back();
+		return task;
+	}
+
+	/* Run one task from the own deque, or stolen from a random victim */
+	bool runOne(unsigned me)
+	{
+		TaskHandle task = popHead(me);
+		if (!task)
+		{
+			static thread_local std::minstd_rand rng(std::hash<std::thread::id>()(std::this_thread::get_id()));
+			unsigned n = queues_.size();
+			unsigned start = rng() % n;
+			for (unsigned k = 0; k < n && !task; k++)
+			{
+				unsigned victim = (start + k) % n;
+				if (victim != me) task = stealTail(victim);
+			}
+		}
+		if (!task) return false;
+		pending_.fetch_sub(1, std::memory_order_relaxed);
+		try
+		{
+			task->fn();
+		}
+		catch (...)
+		{
+			task->error = std::current_exception();
+		}
+		task->fn = nullptr;
+		task->done.store(true, std::memory_order_release);
+		return true;
+	}
+
+	void recordOrphan(std::exception_ptr error)
+	{
+		std::lock_guard<std::mutex> lock(orphanMutex_);
+		if (!orphan_) orphan_ = error;
+		hasOrphan_.store(true, std::memory_order_release);
+	}
+
+	void rethrowOrphan()
+	{
+		if (!hasOrphan_.load(std::memory_order_acquire)) return;
+		std::exception_ptr error;
+		{
+			std::lock_guard<std::mutex> lock(orphanMutex_);
+			std::swap(error, orphan_);
+			hasOrphan_.store(false, std::memory_order_relaxed);
+		}
+		if (error) std::rethrow_exception(error);
+	}
+
+	void workerLoop(unsigned i)
+	{
+		currentWorker() = {this, i};
+		while (true)
+		{
+			if (runOne(i)) continue;
+			std::unique_lock<std::mutex> lock(sleepMutex_);
+			if (stop_) return;
+			sleepCv_.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+				return stop_ || pending_.load(std::memory_order_acquire) > 0;
+			});
+			if (stop_) return;
+		}
+	}
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> workers_;
+	std::atomic<long> pending_{0};
+	std::mutex sleepMutex_;
+	std::condition_variable sleepCv_;
+	bool stop_ = false;
+	std::mutex orphanMutex_;
+	std::exception_ptr orphan_;
+	std::atomic<bool> hasOrphan_{false};
+};
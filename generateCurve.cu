@@ -4,10 +4,12 @@
 #include <chrono>
 
 
-__global__ void cudaGenerateCurve(float* dCurveX, float* dCurveY, float area, float start, float interval, int size)
+// Computed in double, the precision of the GST, so the result is copied
+// straight into the node without a conversion pass
+__global__ void cudaGenerateCurve(double* dCurveX, double* dCurveY, double area, double start, double interval, int size)
 {
   int id = blockIdx.x * blockDim.x + threadIdx.x;
-  float x = start + id * interval;
+  double x = start + id * interval;
   if (id < size)
   {
     dCurveX[id] = x;
@@ -15,40 +17,38 @@ __global__ void cudaGenerateCurve(float* dCurveX, float* dCurveY, float area, fl
   }
 }
 
-void GPUgenerateCurve(Node n, GST& gst, float* dCurveX, float* dCurveY, int blockSize = 512)
+void GPUgenerateCurve(Node n, GST& gst, double* dCurveX, double* dCurveY, int blockSize = 512)
 {
   auto& nodeData = gst.nodes[n];
   std::cout << "curve size = " << nodeData.shapeCurveX.size() << "\n";
 
   size_t arraySize = 1048576;
-  int iBytes = arraySize * sizeof(float);
 
   int gridSize = (arraySize + blockSize - 1) / blockSize;
 
   dim3 block(blockSize);
   dim3 grid(gridSize);
 
-  float maxX = sqrt(nodeData.area / nodeData.par1);
-  float minX = sqrt(nodeData.area / nodeData.par2);
+  double maxX = sqrt(nodeData.area / nodeData.par1);
+  double minX = sqrt(nodeData.area / nodeData.par2);
 
-  float interval = (maxX - minX) / arraySize;
+  double interval = (maxX - minX) / arraySize;
 
   auto startKernel = std::chrono::high_resolution_clock::now();
   cudaGenerateCurve<<<grid, block>>>(dCurveX, dCurveY, nodeData.area, minX, interval, arraySize);
   cudaDeviceSynchronize();
   auto endKernel = std::chrono::high_resolution_clock::now();
 
-  std::vector<float> hCurveX(arraySize);
-  std::vector<float> hCurveY(arraySize);
+  ShapeCurve<double> hCurve(arraySize);
 
   auto startMemcpy = std::chrono::high_resolution_clock::now();
-  cudaMemcpy(hCurveX.data(), dCurveX, arraySize * sizeof(float), cudaMemcpyDeviceToHost);
-  cudaMemcpy(hCurveY.data(), dCurveY, arraySize * sizeof(float), cudaMemcpyDeviceToHost);
+  cudaMemcpy(hCurve.widths().data(), dCurveX, arraySize * sizeof(double), cudaMemcpyDeviceToHost);
+  cudaMemcpy(hCurve.heights().data(), dCurveY, arraySize * sizeof(double), cudaMemcpyDeviceToHost);
   auto endMemcpy = std::chrono::high_resolution_clock::now();
 
+  // The host buffers become the node's curve
   auto startMove = std::chrono::high_resolution_clock::now();
-  nodeData.shapeCurveX = std::move(hCurveX);
-  nodeData.shapeCurveY = std::move(hCurveY);
+  storeCurve(nodeData, std::move(hCurve));
   auto endMove = std::chrono::high_resolution_clock::now();
 
 
@@ -95,13 +95,13 @@ int main() {
   GST gst = fakePartition();
 
   size_t arraySize = 1048576;
-  int iBytes = arraySize * sizeof(float);
+  int iBytes = arraySize * sizeof(double);
 
-  float *dCurveX, *dCurveY;
+  double *dCurveX, *dCurveY;
 
   auto startMalloc = std::chrono::high_resolution_clock::now();
-  cudaMalloc((float**)&dCurveX, iBytes);
-  cudaMalloc((float**)&dCurveY, iBytes);
+  cudaMalloc((double**)&dCurveX, iBytes);
+  cudaMalloc((double**)&dCurveY, iBytes);
   auto endMalloc = std::chrono::high_resolution_clock::now();
 
   cudaMemset(dCurveX, 0, iBytes);
@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <set>
 #include <functional>
+#include "WorkStealingPool.hpp"
+#include "GSTprofile.hpp"
+#include "SlicingTreeArena.hpp"
 
 // 定义ShapePoint结构体，用于存储形状曲线上的点
 struct ShapePoint {
@@ -17,19 +20,12 @@ struct ShapePoint {
     }
 };
 
-// 定义SlicingTreeNode类型，用于表示Slicing Tree的节点
-struct SlicingTreeNode {
-    std::vector<SlicingTreeNode*> children; // 子节点
-    std::set<ShapePoint> shapeCurve;       // 存储子电路的形状曲线
-    bool isHorizontal;    // 是否是水平分割
-    bool isSubcircuit;    // 是否是子电路
-
-    SlicingTreeNode() : isHorizontal(false), isSubcircuit(false) {}
-};
-
 // 定义ShapeCurve类型，用于存储形状曲线上的点
 using ShapeCurve = std::set<ShapePoint>;
 
+// Slicing Tree 以数组形式存放：节点是连续的记录，子节点用下标引用，曲线存放在共享的内存块中
+using SlicingTree = SlicingTreeArena<ShapePoint>;
+
 // 假设的hMetis分割函数，这里进行递归二分割，直到每个子电路的模块数小于等于maxN
 std::vector<std::vector<ShapePoint>> hMetisPartition(const std::vector<ShapePoint>& points, int maxN = 10) {
     std::vector<std::vector<ShapePoint>> partitions;
@@ -70,6 +66,7 @@ ShapeCurve enumerativePacking(const std::vector<ShapePoint>& points) {
 
 // 水平加法操作：将两个曲线水平方向组合
 ShapeCurve addCurvesHorizontally(const ShapeCurve& curveA, const ShapeCurve& curveB) {
+    GST_PROFILE_PHASE(ProfilePhase::Combine);
     ShapeCurve result;
     for (const auto& pointA : curveA) {
         for (const auto& pointB : curveB) {
@@ -81,6 +78,7 @@ ShapeCurve addCurvesHorizontally(const ShapeCurve& curveA, const ShapeCurve& cur
 
 // 翻转操作：基于 W=H 线翻转曲线
 ShapeCurve flipCurveVertically(const ShapeCurve& curve) {
+    GST_PROFILE_PHASE(ProfilePhase::Flip);
     ShapeCurve flippedCurve;
     for (const auto& point : curve) {
         flippedCurve.insert(ShapePoint(point.height, point.width, 0)); // 翻转宽度和高度
@@ -90,6 +88,7 @@ ShapeCurve flipCurveVertically(const ShapeCurve& curve) {
 
 // 合并两个曲线，选择较小宽度的点
 ShapeCurve mergeCurves(const ShapeCurve& curveA, const ShapeCurve& curveB) {
+    GST_PROFILE_PHASE(ProfilePhase::Prune);
     ShapeCurve mergedCurve;
     auto itA = curveA.begin();
     auto itB = curveB.begin();
@@ -126,15 +125,15 @@ ShapeCurve mergeCurves(const ShapeCurve& curveA, const ShapeCurve& curveB) {
     return mergedCurve;
 }
 
-// 合并两个子平面曲线的函数（基于 "⊕" 操作）
-ShapeCurve combineShapeCurves(const SlicingTreeNode* node) {
-    if (node->children.empty()) {
-        return node->shapeCurve; // 如果是叶节点，直接返回该节点的曲线
+// 合并两个子平面曲线的函数（基于 "⊕" 操作），子节点的曲线已经计算好
+ShapeCurve combineShapeCurves(const SlicingTree& tree, uint32_t node) {
+    auto leftView = tree.curve(tree.child(node, 0));
+    ShapeCurve leftCurve(leftView.begin(), leftView.end());
+    if (tree.numChildren(node) == 1) {
+        return leftCurve; // 只有一个分区时没有需要合并的曲线
     }
-
-    // 递归合并子节点的曲线
-    ShapeCurve leftCurve = combineShapeCurves(node->children[0]);
-    ShapeCurve rightCurve = combineShapeCurves(node->children[1]);
+    auto rightView = tree.curve(tree.child(node, 1));
+    ShapeCurve rightCurve(rightView.begin(), rightView.end());
 
     // 水平加法
     ShapeCurve Ch = addCurvesHorizontally(leftCurve, rightCurve);
@@ -146,21 +145,83 @@ ShapeCurve combineShapeCurves(const SlicingTreeNode* node) {
     return mergeCurves(Ch, Cv);
 }
 
-// 递归构建Slicing Tree的函数
-SlicingTreeNode* buildSlicingTree(std::vector<ShapePoint>& points, int maxN = 10) {
+// 子节点总在父节点之前，按顺序扫描一遍即可自底向上算出所有曲线，根节点的曲线即结果
+ShapeCurve combineAllShapeCurves(SlicingTree& tree) {
+    for (uint32_t node = 0; node < tree.size(); node++) {
+        if (tree.isLeaf(node)) continue;
+        ShapeCurve curve = combineShapeCurves(tree, node);
+        tree.setCurve(node, curve.begin(), curve.end());
+    }
+    auto rootView = tree.curve(tree.root());
+    return ShapeCurve(rootView.begin(), rootView.end());
+}
+
+// 统计每个子树的节点数，用于判断是否值得拆分成并行任务
+std::vector<uint32_t> countSubtrees(const SlicingTree& tree) {
+    std::vector<uint32_t> sizes(tree.size(), 1);
+    for (uint32_t node = 0; node < tree.size(); node++) {
+        for (uint32_t k = 0; k < tree.numChildren(node); k++) {
+            sizes[node] += sizes[tree.child(node, k)];
+        }
+    }
+    return sizes;
+}
+
+// 并行版本的 "⊕" 操作：左子树作为任务放入工作窃取线程池，右子树在当前线程计算
+void combineShapeCurvesTask(SlicingTree& tree, uint32_t node, WorkStealingPool& pool,
+                            const std::vector<uint32_t>& sizes, size_t grain) {
+    if (tree.isLeaf(node)) {
+        return;
+    }
+
+    // 子树小于 grain 时直接串行计算，避免任务开销。逐层收集子树的节点，逆序处理时子节点总在父节点之前
+    if (sizes[node] < grain || tree.numChildren(node) == 1) {
+        std::vector<uint32_t> order{node};
+        for (size_t i = 0; i < order.size(); i++) {
+            for (uint32_t k = 0; k < tree.numChildren(order[i]); k++) {
+                order.push_back(tree.child(order[i], k));
+            }
+        }
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            if (tree.isLeaf(*it)) continue;
+            ShapeCurve curve = combineShapeCurves(tree, *it);
+            tree.setCurve(*it, curve.begin(), curve.end());
+        }
+        return;
+    }
+
+    auto leftTask = pool.spawn([&]() {
+        combineShapeCurvesTask(tree, tree.child(node, 0), pool, sizes, grain);
+    });
+    combineShapeCurvesTask(tree, tree.child(node, 1), pool, sizes, grain);
+    pool.wait(leftTask);
+
+    ShapeCurve curve = combineShapeCurves(tree, node);
+    tree.setCurve(node, curve.begin(), curve.end());
+}
+
+ShapeCurve combineShapeCurvesParallel(SlicingTree& tree, WorkStealingPool& pool, size_t grain = 64) {
+    std::vector<uint32_t> sizes = countSubtrees(tree);
+    pool.run([&]() { combineShapeCurvesTask(tree, tree.root(), pool, sizes, grain); });
+    auto rootView = tree.curve(tree.root());
+    return ShapeCurve(rootView.begin(), rootView.end());
+}
+
+// 构建Slicing Tree：先加入每个分区对应的叶节点，最后加入根节点
+SlicingTree buildSlicingTree(std::vector<ShapePoint>& points, int maxN = 10) {
     // 使用hMetis进行分区
     auto partitions = hMetisPartition(points, maxN);
 
-    SlicingTreeNode* root = new SlicingTreeNode();
-
+    SlicingTree tree;
+    tree.reserve(partitions.size() + 1, partitions.size());
+    std::vector<uint32_t> children;
     for (auto& partition : partitions) {
-        SlicingTreeNode* childNode = new SlicingTreeNode();
-        childNode->shapeCurve = enumerativePacking(partition);
-        childNode->isSubcircuit = true;
-        root->children.push_back(childNode);
+        ShapeCurve curve = enumerativePacking(partition);
+        children.push_back(tree.addLeaf(curve.begin(), curve.end()));
     }
+    tree.addNode(children.begin(), children.end());
 
-    return root;
+    return tree;
 }
 
 int main() {
@@ -170,18 +231,16 @@ int main() {
         ShapePoint(3.0, 4.0, 12.0),
         ShapePoint(5.0, 6.0, 30.0)
     };
-    SlicingTreeNode* tree = buildSlicingTree(points);
+    SlicingTree tree = buildSlicingTree(points);
 
     // 合并形状曲线
-    ShapeCurve shapeCurve = combineShapeCurves(tree);
+    WorkStealingPool pool;
+    ShapeCurve shapeCurve = combineShapeCurvesParallel(tree, pool);
 
     // 输出合并后的形状曲线
     for (const auto& point : shapeCurve) {
         std::cout << "Width: " << point.width << ", Height: " << point.height << ", Area: " << point.area << std::endl;
     }
 
-    // 清理分配的内存
-    delete tree;
-
     return 0;
 }
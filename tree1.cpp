@@ -4,6 +4,8 @@
 #include <set>
 #include <functional>
 #include <memory> // for std::unique_ptr
+#include "SlicingTreeArena.hpp"
+#include "WorkStealingPool.hpp"
 
 // Define the module structure to store the shape curve points
 struct module {
@@ -24,19 +26,16 @@ struct module {
     }
 };
 
-// Define SlicingTreeNode type to represent nodes of the Slicing Tree
-struct SlicingTreeNode {
-    std::vector<SlicingTreeNode*> children; // Child nodes
-    std::vector<module> shapeCurve;        // Store the shape curve of the subcircuit
-    bool isHorizontal;                     // Indicates if the division is horizontal
-    bool isSubcircuit;                     // Indicates if the node is a subcircuit
-
-    SlicingTreeNode() : isHorizontal(false), isSubcircuit(false) {}
-};
-
 // Define ShapeCurve type to store shape curve points
 using ShapeCurve = std::vector<module>; 
 
+// The Slicing Tree is stored flat: nodes are records in one vector, children are indices,
+// and the curves live in blocks shared by all nodes
+using SlicingTree = SlicingTreeArena<module>;
+
+// Function declarations for the functions defined later
+ShapeCurve mergeCurves(const ShapeCurve& curveA, const ShapeCurve& curveB);
+
 // Hypothetical hMetis partition function, recursively bisecting until the number of modules is less than or equal to maxN
 std::vector<std::vector<module>> hMetisPartition(const std::vector<module>& points, int maxN = 10) {
     std::vector<std::vector<module>> partitions;
@@ -77,23 +76,79 @@ ShapeCurve enumerativePacking(const std::vector<module>& points) {
     return result;
 }
 
-// Merge two subplane curves (based on "⊕" operation)
-ShapeCurve combineShapeCurves(const SlicingTreeNode* node) {
-    if (node->children.empty()) {
-        return node->shapeCurve; // If it's a leaf node, directly return the curve
+// Merge two subplane curves (based on "⊕" operation), the curves of the children are already computed
+ShapeCurve combineShapeCurves(const SlicingTree& tree, uint32_t node) {
+    auto leftView = tree.curve(tree.child(node, 0));
+    ShapeCurve combinedCurve(leftView.begin(), leftView.end());
+    if (tree.numChildren(node) > 1) {
+        auto rightView = tree.curve(tree.child(node, 1));
+        combinedCurve = mergeCurves(combinedCurve, ShapeCurve(rightView.begin(), rightView.end()));
+    }
+    return combinedCurve;
+}
+
+// Children always come before their parent, so one scan over the nodes computes every curve bottom-up
+ShapeCurve combineAllShapeCurves(SlicingTree& tree) {
+    for (uint32_t node = 0; node < tree.size(); node++) {
+        if (tree.isLeaf(node)) continue;
+        ShapeCurve curve = combineShapeCurves(tree, node);
+        tree.setCurve(node, curve.begin(), curve.end());
+    }
+    auto rootView = tree.curve(tree.root());
+    return ShapeCurve(rootView.begin(), rootView.end());
+}
+
+// Count the nodes of every subtree, used to decide whether a subtree is worth a parallel task
+std::vector<uint32_t> countSubtrees(const SlicingTree& tree) {
+    std::vector<uint32_t> sizes(tree.size(), 1);
+    for (uint32_t node = 0; node < tree.size(); node++) {
+        for (uint32_t k = 0; k < tree.numChildren(node); k++) {
+            sizes[node] += sizes[tree.child(node, k)];
+        }
     }
+    return sizes;
+}
 
-    // Recursively merge the curves of child nodes
-    ShapeCurve combinedCurve;
-    if (!node->children.empty()) {
-        combinedCurve = combineShapeCurves(node->children[0]);
+// Fork-join version of combineAllShapeCurves: the left subtree runs as a task on the
+// work-stealing pool while the right subtree is evaluated inline
+void combineShapeCurvesTask(SlicingTree& tree, uint32_t node, WorkStealingPool& pool,
+                            const std::vector<uint32_t>& sizes, size_t grain) {
+    if (tree.isLeaf(node)) {
+        return;
     }
-    if (node->children.size() > 1) {
-        auto rightCurve = combineShapeCurves(node->children[1]);
-        combinedCurve = mergeCurves(combinedCurve, rightCurve);
+
+    // Subtrees below the grain size are not worth the task overhead. Their nodes are
+    // collected level by level, so in reverse order every child comes before its parent
+    if (tree.numChildren(node) < 2 || sizes[node] < grain) {
+        std::vector<uint32_t> order{node};
+        for (size_t i = 0; i < order.size(); i++) {
+            for (uint32_t k = 0; k < tree.numChildren(order[i]); k++) {
+                order.push_back(tree.child(order[i], k));
+            }
+        }
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            if (tree.isLeaf(*it)) continue;
+            ShapeCurve curve = combineShapeCurves(tree, *it);
+            tree.setCurve(*it, curve.begin(), curve.end());
+        }
+        return;
     }
 
-    return combinedCurve;
+    auto leftTask = pool.spawn([&]() {
+        combineShapeCurvesTask(tree, tree.child(node, 0), pool, sizes, grain);
+    });
+    combineShapeCurvesTask(tree, tree.child(node, 1), pool, sizes, grain);
+    pool.wait(leftTask);
+
+    ShapeCurve curve = combineShapeCurves(tree, node);
+    tree.setCurve(node, curve.begin(), curve.end());
+}
+
+ShapeCurve combineShapeCurvesParallel(SlicingTree& tree, WorkStealingPool& pool, size_t grain = 64) {
+    std::vector<uint32_t> sizes = countSubtrees(tree);
+    pool.run([&]() { combineShapeCurvesTask(tree, tree.root(), pool, sizes, grain); });
+    auto rootView = tree.curve(tree.root());
+    return ShapeCurve(rootView.begin(), rootView.end());
 }
 
 // Horizontal addition operation: combine two curves in the horizontal direction
@@ -154,19 +209,20 @@ ShapeCurve mergeCurves(const ShapeCurve& curveA, const ShapeCurve& curveB) {
     return mergedCurve;
 }
 
-// Recursively build the Slicing Tree
-std::unique_ptr<SlicingTreeNode> buildSlicingTree(std::vector<module>& points, int maxN = 10) {
+// Build the Slicing Tree: one leaf per partition first, then the root over all of them
+SlicingTree buildSlicingTree(std::vector<module>& points, int maxN = 10) {
     auto partitions = hMetisPartition(points, maxN);
-    auto root = std::make_unique<SlicingTreeNode>();  // Use smart pointer
+    SlicingTree tree;
+    tree.reserve(partitions.size() + 1, partitions.size());
 
+    std::vector<uint32_t> children;
     for (auto& partition : partitions) {
-        auto childNode = std::make_unique<SlicingTreeNode>();
-        childNode->shapeCurve = enumerativePacking(partition);
-        childNode->isSubcircuit = true;
-        root->children.push_back(std::move(childNode));  // Use move semantics
+        ShapeCurve curve = enumerativePacking(partition);
+        children.push_back(tree.addLeaf(curve.begin(), curve.end()));
     }
+    tree.addNode(children.begin(), children.end());
 
-    return root;
+    return tree;
 }
 
 int main() {
@@ -180,7 +236,8 @@ int main() {
     auto tree = buildSlicingTree(points);
 
     // Combine shape curves
-    ShapeCurve shapeCurve = combineShapeCurves(tree.get());
+    WorkStealingPool pool;
+    ShapeCurve shapeCurve = combineShapeCurvesParallel(tree, pool);
 
     // Output the merged shape curves
     for (const auto& point : shapeCurve) {
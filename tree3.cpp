@@ -4,6 +4,7 @@
 #include <set>
 #include <functional>
 #include <memory> // for std::unique_ptr
+#include "SlicingTreeArena.hpp"
 #include <cstdlib>  // for rand and srand
 #include <ctime>    // for seeding rand
 
@@ -36,28 +37,21 @@ struct ShapeCurveRange {
 };
 
 
-// Define SlicingTreeNode type to represent nodes of the Slicing Tree
-struct SlicingTreeNode {
-    std::vector<std::unique_ptr<SlicingTreeNode>> children;  
-    std::vector<module> shapeCurve;
-    bool isHorizontal;
-    bool isSubcircuit;
-    
-    SlicingTreeNode() : isHorizontal(false), isSubcircuit(false) {}
-};
-
-
 // Define ShapeCurve type to store shape curve modules
 using ShapeCurve = std::vector<module>;
 
+// The Slicing Tree is stored flat: nodes are records in one vector, children are indices,
+// and the curves live in blocks shared by all nodes
+using SlicingTree = SlicingTreeArena<module>;
+
 // Function declarations for the functions defined later
 std::vector<std::vector<module>> hMetisPartition(const std::vector<module>& modules, int maxN);
 ShapeCurve enumerativePacking(const std::vector<module>& modules);
-ShapeCurve combineShapeCurves(const SlicingTreeNode* node);
+ShapeCurve combineShapeCurves(const SlicingTree& tree, uint32_t node);
 ShapeCurve mergeCurves(const ShapeCurve& curveA, const ShapeCurve& curveB);
 ShapeCurve addCurvesHorizontally(const ShapeCurve& curveA, const ShapeCurve& curveB);
 ShapeCurve flipCurveVertically(const ShapeCurve& curve);
-std::unique_ptr<SlicingTreeNode> buildSlicingTree(std::vector<module>& modules, int maxN);
+SlicingTree buildSlicingTree(std::vector<module>& modules, int maxN);
 
 // Hypothetical hMetis partition function, recursively bisecting until the number of modules is less than or equal to maxN
 std::vector<std::vector<module>> hMetisPartition(const std::vector<module>& modules, int maxN = 10) {
@@ -99,23 +93,26 @@ ShapeCurve enumerativePacking(const std::vector<module>& modules) {
     return ShapeCurve(resultSet.begin(), resultSet.end());
 }
 
-// Merge two subplane curves (based on "⊕" operation)
-ShapeCurve combineShapeCurves(const SlicingTreeNode* node) {
-    if (node->children.empty()) {
-        return node->shapeCurve; // If it's a leaf node, directly return the curve
+// Merge two subplane curves (based on "⊕" operation), the curves of the children are already computed
+ShapeCurve combineShapeCurves(const SlicingTree& tree, uint32_t node) {
+    auto leftView = tree.curve(tree.child(node, 0));
+    ShapeCurve combinedCurve(leftView.begin(), leftView.end());
+    if (tree.numChildren(node) > 1) {
+        auto rightView = tree.curve(tree.child(node, 1));
+        combinedCurve = mergeCurves(combinedCurve, ShapeCurve(rightView.begin(), rightView.end()));
     }
+    return combinedCurve;
+}
 
-    // Recursively merge the curves of child nodes
-    ShapeCurve combinedCurve;
-    if (!node->children.empty()) {
-        combinedCurve = combineShapeCurves(node->children[0].get());
-    }
-    if (node->children.size() > 1) {
-        auto rightCurve = combineShapeCurves(node->children[1].get());
-        combinedCurve = mergeCurves(combinedCurve, rightCurve);
+// Children always come before their parent, so one scan over the nodes computes every curve bottom-up
+ShapeCurve combineAllShapeCurves(SlicingTree& tree) {
+    for (uint32_t node = 0; node < tree.size(); node++) {
+        if (tree.isLeaf(node)) continue;
+        ShapeCurve curve = combineShapeCurves(tree, node);
+        tree.setCurve(node, curve.begin(), curve.end());
     }
-
-    return combinedCurve;
+    auto rootView = tree.curve(tree.root());
+    return ShapeCurve(rootView.begin(), rootView.end());
 }
 
 // Horizontal addition operation: combine two curves in the horizontal direction
@@ -189,16 +186,17 @@ void printCurve(const std::vector<module>& curve) {
 }
 
 
-std::unique_ptr<SlicingTreeNode> buildSlicingTree(std::vector<module>& modules, int maxN = 10) {
+SlicingTree buildSlicingTree(std::vector<module>& modules, int maxN = 10) {
     auto partitions = hMetisPartition(modules, maxN);
-    auto root = std::make_unique<SlicingTreeNode>();
+    SlicingTree tree;
+    tree.reserve(partitions.size() + 1, partitions.size());
+    std::vector<uint32_t> children;
     for (auto& partition : partitions) {
-        auto childNode = std::make_unique<SlicingTreeNode>();
-        childNode->shapeCurve = enumerativePacking(partition);
-        childNode->isSubcircuit = true;
-        root->children.push_back(std::move(childNode));  
+        ShapeCurve curve = enumerativePacking(partition);
+        children.push_back(tree.addLeaf(curve.begin(), curve.end()));
     }
-    return root;
+    tree.addNode(children.begin(), children.end());
+    return tree;
 }
 
 
@@ -3,6 +3,7 @@
 #include <memory>
 #include <algorithm>
 #include <utility> 
+#include "PointsCurve.hpp"
 
 //1，partition by hmetis and build the slicing tree
 //The subcircuits obtained after partitioning the original circuit with hmetis are used as input, and N modules are included in each subcircuit
@@ -24,15 +25,8 @@ struct SubCircuit {
 };
 
 
-template pair make_pair(T1 w, T2 h) { 
-	return pair(w, h);
-}
-
-
-std::vector<std::pair<double, double>> Module; //Module is a vector of dimension 1x2 containing the variables w,h, which mean the width and height of the module
 std::vector<Module> IniCircuit;  //IniCircuit is an Mx2 dimensional matrix, consisting of M modules containing M/N subcircuits
-std::vector<Module> SubCircuit;  //A SubCircuit is an Nx2 dimensional matrix, consisting of N modules
-std::vector<Module> Circuit;  
+std::vector<SubCircuit> SubCircuits;  //A SubCircuit is an Nx2 dimensional matrix, consisting of N modules
 
 // bisection 
 std::pair<SubCircuit, SubCircuit> bisection(const SubCircuit& Circuit, int N) {
@@ -48,14 +42,14 @@ std::pair<SubCircuit, SubCircuit> bisection(const SubCircuit& Circuit, int N) {
 }
 
 //The hmetisfunc function is constructed, which makes it possible to recursively bisect the original circuit until each leaf node contains N modules
-void hmetisfunc(std::vector<Module>& IniCircuit, int N, std::vector<Module>& SubCircuit){
-	if (IniCircuit.size() <= N) {
-	SubCircuit.push_back(IniCircuit);
+void hmetisfunc(const SubCircuit& Circuit, int N, std::vector<SubCircuit>& SubCircuits){
+	if (Circuit.modules.size() <= size_t(N)) {
+	SubCircuits.push_back(Circuit);
 	return;
 	}
-	auto [left, right] = bisection(const SubCircuit& IniCircuit, int N);
-	hmetisfunc(left.modules, N, SubCircuit);
-	hmetisfunc(right.modules, N, SubCircuit);
+	auto [left, right] = bisection(Circuit, N);
+	hmetisfunc(left, N, SubCircuits);
+	hmetisfunc(right, N, SubCircuits);
 }
 
 
@@ -93,7 +87,7 @@ void insertright(Node* &root, int val) {
 }
 
 
-Node* Tree(std::vector<Module>& modules, int N) {
+Node* Tree(std::vector<Module>&, int) {
     Node* root = NULL; 
     insertleft(root, 1); 
     insertleft(root->left, 2); 
@@ -108,20 +102,16 @@ Node* Tree(std::vector<Module>& modules, int N) {
 
 //2，combine the curve and shape the merge curve
 
-typedef std::vector<std::pair<double, double>> Points;
-Points curve(const std::pair<double, double>& module, int num_points=100);
-
 Points curve(const Module& module, int num_points=100) {
     Points curvePoints;
-    double x_min, x_max, step;
 
-    double x_min = std::min(module.first,module.second);
-    double x_max = std::max(module.first,module.second);
-    double step = (x_max - x_min) / (num_points - 1);
+    double x_min = std::min(module.w,module.h);
+    double x_max = std::max(module.w,module.h);
+    double step = num_points > 1 ? (x_max - x_min) / (num_points - 1) : 0;
 
     for (int i = 0; i < num_points; ++i) {
         double x = x_min + i * step;
-        double y = module.first * module.second / x;
+        double y = module.w * module.h / x;
 
         curvePoints.emplace_back(x, y);
     }
@@ -130,74 +120,9 @@ Points curve(const Module& module, int num_points=100) {
 }
 
 
-//addition
-Points addition(const Points& curveA, const Points& curveB) {
-    Points Ch;  
-    for (const auto& pointA : curveA) {
-        for (const auto& pointB : curveB) {
-            double newx = pointA.x + pointB.x;
-            double newy = pointA.y;
-            Ch.push_back(std::make_pair(newx, newy));  
-        }
-    }
-    return Ch;
-}
-
-
-//flipping
-Points flipping(const Points& curveCh) {
-    Points Cv;  
-    for (const auto& pointCh : curveCh) {
-        Cv.push_back(module(pointCh.y, pointCh.x)); 
-    }
-    return Cv;
-}
-
-
-bool findXForY(const Points& curve, double y, double& x) {
-    for (const auto& point : curve) {
-        if (point.second == y) {
-            x = point.first;
-            return true;
-        }
-    }
-    return false;
-}
-
-//merging
-Points merging(const Points& curve, const Points& curveCh, const Points& curveCv, int num_points=100) {
-    Points C; 
-    Points allPoints;
-    allPoints.reserve(curveCh.size() + curveCv.size()); 
-
-    std::merge(curveCh.begin(), curveCh.end(), curveCv.begin(), curveCv.end(), std::back_inserter(allPoints),
-              [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
-                  return a.second < b.second;
-              });
-    
-    double x_min = std::min(curveCh.first, curveCv.first);
-    double x_max = std::max(curveCh.second, curveCh.second);
-    double step = (x_max - x_min) / (num_points - 1);
-    double x_last = -1; 
-    double y_last = -1; 
-
-    for (double y = y_min; y <= y_max; y += step) {
-        double curveC.second = y;
-        double x = min(findXForY(curveCh, y, x), findXForY(curveCv, y, x)); 
-
-        if ( x < x_last ) {
-            curveC.first = x;
-            curveC.push_back({x, y}); 
-        }
-    }
-
-    return C;
-}
-
-
 //print the curve points of C
 void printcurve(const Points& points, int num_points=100) {
-    for (int i = 0; i < num_points && i < points.size(); ++i) {
+    for (int i = 0; i < num_points && size_t(i) < points.size(); ++i) {
         const auto& point = points[i];
         std::cout << "Point " << i << ": (" << point.first << ", " << point.second << ")" << std::endl;
     }
@@ -209,7 +134,7 @@ int main() {
     const size_t M = 4; // IniCircuit is the matrix of Mx2
     const size_t N = 2;  // SubCircuit is the matrix of Nx2
 	
-    for (int i = 0; i < M; ++i) {
+    for (size_t i = 0; i < M; ++i) {
     	double w, h;
         std::cout << "Enter w, h for module " << i + 1 << ": ";
         std::cin >> w >> h ;
@@ -217,7 +142,9 @@ int main() {
     }
 
 
-    hmetisfunc(IniCircuit, N, SubCircuit);
+    SubCircuit Circuit(M);
+    Circuit.modules = IniCircuit;
+    hmetisfunc(Circuit, N, SubCircuits);
 
     std::cout << "SubCircuits:" << std::endl;
     for (const auto& Sub : SubCircuits) {
@@ -227,8 +154,16 @@ int main() {
         std::cout << std::endl;
     }
     
-    Points curveC = merging(curveCh, curveCv);
-    printcurve(curveC, 100);
+    for (const auto& Sub : SubCircuits) {
+        Points curveCh = curve(Sub.modules[0], 100);
+        for (size_t i = 1; i < Sub.modules.size(); ++i) {
+            curveCh = addition(curveCh, curve(Sub.modules[i], 100));
+        }
+        Points curveCv = flipping(curveCh);
+        Points curveC = merging(curveCh, curveCv);
+        std::cout << "Curve C points:" << std::endl;
+        printcurve(curveC, 100);
+    }
 
     return 0;
 }
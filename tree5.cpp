@@ -3,6 +3,7 @@
 #include <memory>
 #include <algorithm>
 #include <utility> // For std::pair
+#include "PointsCurve.hpp"
 
 //1，partition by hmetis and build the slicing tree
 //The circuit_subs obtained after partitioning the original circuit with hmetis are used as input, and N shapes are included in each circuit_sub
@@ -24,10 +25,8 @@ struct circuit_sub {
 };
 
 
-std::vector<std::pair<double, double>> shape; //shape is a vector of dimension 1x2 containing the variables w,h, which mean the width and height of the shape
 std::vector<shape> circuit_ini;  //circuit_ini is an Mx2 dimensional matrix, consisting of M shapes containing M/N circuit_subs
-std::vector<shape> circuit_sub;  //A circuit_sub is an Nx2 dimensional matrix, consisting of N shapes
-std::vector<shape> circuit;  
+std::vector<circuit_sub> circuit_subs;  //A circuit_sub is an Nx2 dimensional matrix, consisting of N shapes
 
 // bisection 
 std::pair<circuit_sub, circuit_sub> bisection(const circuit_sub& circuit, int N) {
@@ -43,14 +42,14 @@ std::pair<circuit_sub, circuit_sub> bisection(const circuit_sub& circuit, int N)
 }
 
 //The hmetisfunc function is constructed, which makes it possible to recursively bisect the original circuit until each leaf node contains N shapes
-void hmetisfunc(std::vector<shape>& circuit_ini, int N, std::vector<shape>& circuit_sub){
-	if (circuit_ini.size() <= N) {
-	circuit_sub.push_back(circuit_ini);
+void hmetisfunc(const circuit_sub& circuit, int N, std::vector<circuit_sub>& circuit_subs){
+	if (circuit.shapes.size() <= size_t(N)) {
+	circuit_subs.push_back(circuit);
 	return;
 	}
-    auto [left, right] = bisection(circuit_ini, N);
-	hmetisfunc(left.shapes, N, circuit_sub);
-	hmetisfunc(right.shapes, N, circuit_sub);
+    auto [left, right] = bisection(circuit, N);
+	hmetisfunc(left, N, circuit_subs);
+	hmetisfunc(right, N, circuit_subs);
 }
 
 
@@ -82,7 +81,7 @@ void insert(Node* &root, int val, bool isLeft) {
     }
 }
 
-Node* Tree(std::vector<shape>& shapes, int N) {
+Node* Tree(std::vector<shape>&, int) {
     Node* root = NULL; 
     insert(root, 1, true); 
     insert(root->left, 2, true); 
@@ -97,20 +96,16 @@ Node* Tree(std::vector<shape>& shapes, int N) {
 
 //2，combine the curve and shape the merge curve
 
-typedef std::vector<std::pair<double, double>> Points;
-Points curve(const std::pair<double, double>& shape, int num_points=100);
-
 Points curve(const shape& shape, int num_points=100) {
     Points curvePoints;
-    double x_min, x_max, step;
 
-    double x_min = std::min(shape.first,shape.second);
-    double x_max = std::max(shape.first,shape.second);
-    double step = (x_max - x_min) / (num_points - 1);
+    double x_min = std::min(shape.w,shape.h);
+    double x_max = std::max(shape.w,shape.h);
+    double step = num_points > 1 ? (x_max - x_min) / (num_points - 1) : 0;
 
     for (int i = 0; i < num_points; ++i) {
         double x = x_min + i * step;
-        double y = shape.first * shape.second / x;
+        double y = shape.w * shape.h / x;
 
         curvePoints.emplace_back(x, y);
     }
@@ -119,62 +114,6 @@ Points curve(const shape& shape, int num_points=100) {
 }
 
 
-//addition
-Points addition(const Points& curveA, const Points& curveB) {
-    Points Ch;
-    auto itA = curveA.begin();
-    auto itB = curveB.begin();
-
-    while (itA != curveA.end()) {
-        double x_a = itA->first;
-        double y_a = itA->second;
-        
-        auto itB_upper = curveB.begin();
-        while (itB_upper != curveB.end() && itB_upper->second < y_a) {
-            itB_upper++; 
-        }
-
-        auto itB_lower = itB_upper;
-        if (itB_upper != curveB.begin()) {
-            itB_lower--;  
-        }
-
-        double x_b1 = itB_upper->first;
-        double x_b2 = itB_lower->first;
-
-        double x_c1 = x_a + x_b1;
-        double y_c1 = y_a;  
-        double x_c2 = x_a + x_b2;
-        double y_c2 = y_a;  
-
-        double area1 = x_c1 * y_c1;
-        double area2 = x_c2 * y_c2;
-
-        if (area1 < area2) {
-            Ch.push_back({x_c1, y_c1});
-        } 
-        else {
-            Ch.push_back({x_c2, y_c2});
-        }
-
-        ++itA; 
-    }
-
-    return Ch;
-}
-
-
-
-//flipping
-Points flipping(const Points& curveCh) {
-    Points Cv;  
-    for (const auto& pointCh : curveCh) {
-        Cv.push_back(std::make_pair(pointCh.y, pointCh.x)); 
-    }
-    return Cv;
-}
-
-
 // //merging
 // Points merging(const Points& curveCh, const Points& curveCv) {
 //     Points C;
@@ -247,60 +186,9 @@ Points flipping(const Points& curveCh) {
 
 
 
-//merging
-Points merging(const Points& curveCh, const Points& curveCv) {
-    Points C;
-    auto itCh = curveCh.begin();
-    auto itCv = curveCv.begin();
-
-    while(curveCh.begin()->second < curveCv.begin()->second) {
-        while(itCh->second < curveCv.begin().second){
-            C.push_back({itCh->first, itCh->second});
-            ++itCh;
-        }
-        while(itCh = curveCh.end() && curveCh.end().second < curveCv.end().second){
-            C.push_back({itCv->first, itCv->second});
-            ++itCv;
-        }
-    }
-
-    while(curveCh.begin()->second > curveCv.begin()->second) {
-        while(itCv->second < curveCh.begin().second){
-            C.push_back({itCv->first, itCv->second});
-            ++itCv;
-        }
-        while(itCv = curveCv.end() && curveCv.end().second < curveCh.end().second){
-            C.push_back({itCh->first, itCh->second});
-            ++itCh;
-        }
-    }
-
-    while (itCh != curveCh.end() && itCv != curveCv.end()) {
-        double x_ch = itCh->first;
-        double y_ch = itCh->second;
-            
-        while (itCv->second < y_ch) {
-            itCv++; 
-        }
-
-        double x_cv = itCv->first;
-        if (x_cv < x_ch) {
-            C.push_back({x_cv, y_ch});
-        } 
-        else {
-            C.push_back({x_ch, y_ch});
-        }   
-
-        ++itCh; 
-    }
-
-    return C;
-}
-
-
 //print the curve points of C
 void printcurve(const Points& points, int num_points=100) {
-    for (int i = 0; i < num_points && i < points.size(); ++i) {
+    for (int i = 0; i < num_points && size_t(i) < points.size(); ++i) {
         const auto& point = points[i];
         std::cout << "Point " << i << ": (" << point.first << ", " << point.second << ")" << std::endl;
     }
@@ -312,7 +200,7 @@ int main() {
     const size_t M = 4; // circuit_ini is the matrix of Mx2
     const size_t N = 2;  // circuit_sub is the matrix of Nx2
 	
-    for (int i = 0; i < M; ++i) {
+    for (size_t i = 0; i < M; ++i) {
     	double w, h;
         std::cout << "Enter w, h for shape " << i + 1 << ": ";
         std::cin >> w >> h ;
@@ -320,18 +208,28 @@ int main() {
     }
 
 
-    hmetisfunc(circuit_ini, N, circuit_sub);
+    circuit_sub circuit(M);
+    circuit.shapes = circuit_ini;
+    hmetisfunc(circuit, N, circuit_subs);
 
     std::cout << "circuit_sub:" << std::endl;
-    for (const auto& Sub : circuit_sub) {
+    for (const auto& Sub : circuit_subs) {
         for (const auto& mod : Sub.shapes) {
             std::cout << "(" << mod.w << ", " << mod.h << ") ";
         }
         std::cout << std::endl;
     }
     
-    Points curveC = merging(curveCh, curveCv);
-    printcurve(curveC, 100);
+    for (const auto& Sub : circuit_subs) {
+        Points curveCh = curve(Sub.shapes[0], 100);
+        for (size_t i = 1; i < Sub.shapes.size(); ++i) {
+            curveCh = addition(curveCh, curve(Sub.shapes[i], 100));
+        }
+        Points curveCv = flipping(curveCh);
+        Points curveC = merging(curveCh, curveCv);
+        std::cout << "Curve C points:" << std::endl;
+        printcurve(curveC, 100);
+    }
 
     return 0;
 }
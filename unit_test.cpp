@@ -4,6 +4,7 @@
 #include <utility> 
 #include <cmath>
 #include <chrono> 
+#include "PointsCurve.hpp"
 
 //1，partition by hmetis and build the slicing tree
 //The circuit_subs obtained after partitioning the original circuit with hmetis are used as input, and N shapes are included in each circuit_sub
@@ -102,7 +103,6 @@ struct shape{
 
 
 
-typedef std::vector<std::pair<double, double>> Points;
 //Points curve(const std::pair<double, double>& shape, int num_points=100);
 
 Points curve(const shape& shape, int num_points) {
@@ -123,99 +123,6 @@ Points curve(const shape& shape, int num_points) {
 }
 
 
-//addition
-Points addition(const Points& curveA, const Points& curveB) {
-    Points Ch;
-    auto itA = curveA.begin();
-    auto itB = curveB.begin();
-
-    while (itA != curveA.end()) {
-        double x_a = itA->first;
-        double y_a = itA->second;
-        
-        auto itB_upper = curveB.begin();
-        while (itB_upper != curveB.end() && itB_upper->second < y_a) {
-            itB_upper++; 
-        }
-
-        auto itB_lower = itB_upper;
-        if (itB_upper != curveB.begin()) {
-            itB_lower--;  
-        }
-
-        double x_b1 = itB_upper->first;
-        double x_b2 = itB_lower->first;
-
-        double x_c1 = x_a + x_b1;
-        double y_c1 = y_a;  
-        double x_c2 = x_a + x_b2;
-        double y_c2 = y_a;  
-
-        double area1 = x_c1 * y_c1;
-        double area2 = x_c2 * y_c2;
-
-        if (area1 < area2) {
-            Ch.push_back({x_c1, y_c1});
-        } 
-        else {
-            Ch.push_back({x_c2, y_c2});
-        }
-
-        ++itA; 
-    }
-
-    return Ch;
-}
-
-
-
-//flipping
-Points flipping(const Points& curveCh) {
-    Points Cv;  
-    for (const auto& pointCh : curveCh) {
-        Cv.push_back(std::make_pair(pointCh.second, pointCh.first)); 
-    }
-    return Cv;
-}
-
-//merging
-Points merging(const Points& curveCh, const Points& curveCv) {
-    Points C;
-    auto itCh = curveCh.begin();
-    auto itCv = curveCv.begin();
-	double y_1 = 0;
-	
-    while (itCh != curveCh.end() && itCv != curveCv.end()) {
-        if (itCh->second == itCv->second) {
-            y_1 = itCh->second; 
-            
-        }
-    }
-
-    while (itCh != curveCh.end() && itCv != curveCv.end()) {
-        double x_ch = itCh->first;
-        double y_ch = itCh->second;
-        double x_cv = itCv->first;
-        double y_cv = itCv->second;
-
-        if (y_ch == y_1) {
-            C.push_back({x_ch, y_ch}); 
-        } 
-		else if (y_ch < y_1) {
-            C.push_back({x_ch, y_ch}); 
-            ++itCh;
-        } 
-		else {
-            C.push_back({x_cv, y_cv}); 
-            ++itCv;
-        }
-    }
-    return C;
-}
-
-
-
-
 //    while (itCh != curveCh.end() && itCv != curveCv.end()) {
 //        double x_ch = itCh->first;
 //        double y_ch = itCh->second;
@@ -396,7 +303,7 @@ Points merging(const Points& curveCh, const Points& curveCv) {
 
 //print the curve points of C
 void printcurve(const Points& points, int num_points=100) {
-    for (int i = 0; i < num_points && i < points.size(); ++i) {
+    for (int i = 0; i < num_points && size_t(i) < points.size(); ++i) {
         const auto& point = points[i];
 //        std::cout << "Point " << i << ": (" << point.first << ", " << point.second << ")" << std::endl;
         std::cout << point.first << "   " << point.second << std::endl;